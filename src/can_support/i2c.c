@@ -1,6 +1,8 @@
 #include "i2c.h"
 #include <xc.h>
 
+#include "../pic_common/i2c_regs.h"
+
 void i2c_set_address(uint8_t address) {
     I2C1ADR0 = address << 1;
 }
@@ -16,6 +18,8 @@ void i2c_initialize() {
     RC3PPS = 0x21; // I2C 1 SCL
     
     I2C1CON0bits.MODE = 0b000; // Slave with 7 bit addressing
+    I2C1PIEbits.ADRIE = 1; // Address match, so we know where each transaction starts
+    I2C1PIEbits.PCIE = 1; // Stop condition, so we know when a read has finished
     I2C1PIEbits.WRIE = 1;
     PIE3bits.I2C1TXIE = 1;
     PIE3bits.I2C1IE = 1;
@@ -25,18 +29,50 @@ void i2c_initialize() {
 }
 
 void i2c_handle_interrupt() {
+    // If a transaction addressed to us is starting
+    if (I2C1PIRbits.ADRIF) {
+        if (I2C1STAT0bits.R) {
+            i2c_regs_start_read();
+        } else {
+            i2c_regs_start_write();
+        }
+        I2C1PIRbits.ADRIF = 0;
+    }
     // If this is an I2C write
     if (I2C1STAT1bits.RXBF) {
-        uint8_t cmd = I2C1RXB;
-        // we care about the second from last bit
-        LATC2 = (cmd & 0b10) > 0;
+        i2c_regs_write_byte(I2C1RXB);
         I2C1CON1bits.ACKDT = 0;
         I2C1PIRbits.WRIF = 0;
     }
     // If this is an I2C read
     if (PIR3bits.I2C1TXIF) {
-        I2C1TXB = 0;
+        I2C1TXB = i2c_regs_read_byte();
+    }
+    // If the transaction is over
+    if (I2C1PIRbits.PCIF) {
+        i2c_regs_stop();
+        I2C1PIRbits.PCIF = 0;
     }
     PIR3bits.I2C1IF = 0;
     I2C1CON0bits.CSTR = 0;
-}
\ No newline at end of file
+}
+
+// This board stands in for a relay board on the bus, so it uses the same register map
+// as src/relay_pic/i2c.h. It has no limit switches or current sense, those read as 0.
+
+static void read_control(uint8_t *dest) {
+    dest[0] = LATC2 << 1;
+}
+
+static void write_control(const uint8_t *src) {
+    // we care about the select bit (second from last)
+    LATC2 = (src[0] & 0b10) > 0;
+}
+
+const i2c_reg_t i2c_registers[] = {
+    {1, NULL, NULL}, // RELAY_REG_STATUS
+    {2, NULL, NULL}, // RELAY_REG_CURR_SENSE_1
+    {2, NULL, NULL}, // RELAY_REG_CURR_SENSE_2
+    {1, read_control, write_control}, // RELAY_REG_CONTROL
+};
+const uint8_t i2c_num_registers = sizeof(i2c_registers) / sizeof(i2c_registers[0]);
@@ -1,5 +1,6 @@
 #include <xc.h>
 #include "i2c.h"
+#include "../pic_common/i2c_regs.h"
 
 #include "system_init.h"
 
@@ -36,6 +37,7 @@ void main(void) {
     
     while (1) {
         read_dip_inputs(); // Update if our address changes
+        i2c_regs_publish(); // Keep the snapshot served to I2C reads up to date
     }
 }
 
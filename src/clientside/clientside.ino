@@ -3,11 +3,13 @@
 #include "config.hpp"
 #include "hardware.hpp"
 #include "lcd.hpp"
+#include "switches.hpp"
 
 void setup() {
   hardware::setup();
   hardware::set_status_startup();
   lcd::setup();
+  switches::setup();
 
   Serial.begin(115200); // USB connection
   Serial3.begin(9600);  // Towerside connection
@@ -24,15 +26,17 @@ void setup() {
   // Avoid the status showing as connected for the first few seconds on
   // startup if we aren't really
   bool any_messages_received = false;
+  bool switch_changed = false;
   while (true) {
     towerside_communicator.read_byte();
     if (towerside_communicator.get_message(&last_sensor_msg)) {
       any_messages_received = true;
       lcd::update(last_sensor_msg);
     }
+    lcd::flush();
 
-    bool has_contact = towerside_communicator.seconds_since_last_contact() <
-                       config::COMMUNICATION_TIMEOUT_S;
+    bool has_contact = towerside_communicator.ms_since_last_frame() <
+                       config::COMMUNICATION_TIMEOUT_MS;
     if (has_contact && any_messages_received) {
       hardware::set_status_connected();
     } else {
@@ -45,10 +49,19 @@ void setup() {
       last_switch_positions = config::build_command_message();
     }
 
-    if ((millis() > last_sent_time + config::COMMAND_MESSAGE_INTERVAL_MS)) {
-      // condition: passed COMMAND_MESSAGE_INTERVAL_MS since last time sent message
+    // A switch change stays pending until the rate limit lets it through
+    switch_changed |= switches::take_changed() && armed;
+    bool send_change = switch_changed && millis() - last_sent_time >= config::COMMAND_MESSAGE_MIN_INTERVAL_MS;
+
+    if (send_change || (millis() > last_sent_time + config::COMMAND_MESSAGE_INTERVAL_MS)) {
+      // condition: a switch changed, or passed COMMAND_MESSAGE_INTERVAL_MS since last time sent message
       last_sent_time = millis();
       towerside_communicator.send(last_switch_positions);
+      if (send_change) {
+        // Towerside needs the same command twice in a row, don't make it wait for the next one
+        towerside_communicator.send(last_switch_positions);
+        switch_changed = false;
+      }
 
       usb_communicator.send(config::USBMessage{
         .actuator_msg = last_switch_positions,
@@ -1,25 +1,26 @@
 #include "config.hpp"
 #include "common/mock_arduino.hpp"
 #include "pinout.hpp"
+#include "switches.hpp"
 
 namespace config {
 
 ActuatorMessage build_command_message() {
   return ActuatorMessage{
-      .ov101 = digitalRead(pinout::MISSILE_SWITCH_1),
-      .ov102 = digitalRead(pinout::MISSILE_SWITCH_2),
-      .ov103 = digitalRead(pinout::MISSILE_SWITCH_6),
-      .injector_valve = digitalRead(pinout::MISSILE_SWITCH_INJECTOR),
-      .tank_heating_1 = digitalRead(pinout::MISSILE_SWITCH_8),
-      .tank_heating_2 = digitalRead(pinout::MISSILE_SWITCH_8),
+      .ov101 = switches::read(pinout::MISSILE_SWITCH_1),
+      .ov102 = switches::read(pinout::MISSILE_SWITCH_2),
+      .ov103 = switches::read(pinout::MISSILE_SWITCH_6),
+      .injector_valve = switches::read(pinout::MISSILE_SWITCH_INJECTOR),
+      .tank_heating_1 = switches::read(pinout::MISSILE_SWITCH_8),
+      .tank_heating_2 = switches::read(pinout::MISSILE_SWITCH_8),
       .ignition_primary =
-          digitalRead(pinout::MISSILE_SWITCH_IGNITION_PRI) &&
-          !digitalRead(pinout::MISSILE_SWITCH_IGNITION_SEC) &&
-          !digitalRead(pinout::MISSILE_SWITCH_IGNITION_FIRE), // active low
+          switches::read(pinout::MISSILE_SWITCH_IGNITION_PRI) &&
+          !switches::read(pinout::MISSILE_SWITCH_IGNITION_SEC) &&
+          !switches::read(pinout::MISSILE_SWITCH_IGNITION_FIRE), // active low
       .ignition_secondary =
-          digitalRead(pinout::MISSILE_SWITCH_IGNITION_SEC) &&
-          !digitalRead(pinout::MISSILE_SWITCH_IGNITION_PRI) &&
-          !digitalRead(pinout::MISSILE_SWITCH_IGNITION_FIRE), // active low
+          switches::read(pinout::MISSILE_SWITCH_IGNITION_SEC) &&
+          !switches::read(pinout::MISSILE_SWITCH_IGNITION_PRI) &&
+          !switches::read(pinout::MISSILE_SWITCH_IGNITION_FIRE), // active low
   };
 }
 
@@ -2,6 +2,7 @@
 #define CONFIG_H
 
 #include "common/config.hpp"
+#include "common/scale.hpp"
 #include <stdint.h>
 
 namespace config {
@@ -9,12 +10,14 @@ namespace config {
 ActuatorMessage build_command_message();
 
 constexpr unsigned long COMMAND_MESSAGE_INTERVAL_MS = 100;
+// Switch changes are sent straight away, but no closer together than this. Towerside only acts
+// on two identical messages in a row, so each change goes out twice, about 21ms at 9600 baud.
+constexpr unsigned long COMMAND_MESSAGE_MIN_INTERVAL_MS = 25;
 constexpr unsigned long COMMUNICATION_RESET_MS = 50;
-constexpr uint16_t COMMUNICATION_TIMEOUT_S = 3;
+constexpr unsigned long COMMUNICATION_TIMEOUT_MS = 3000;
 
-constexpr uint16_t BATT_SCALE_PRE_OFFSET = -11;
-constexpr uint16_t BATT_SCALE_NUM = 1;
-constexpr uint16_t BATT_SCALE_DEN = 7;
+// Battery voltage in tenths of a volt from the analog reading, (adc - 11) / 7
+typedef scale::Scale<1023, 1, 7, -11, 0xFF> BattDv;
 
 ; // random semicolon to fix clangd warning bug, see: https://stackoverflow.com/questions/72456118/why-does-clang-give-a-warning-unterminated-pragma-pack-push-at-end-of-f
 #pragma pack(push, 1)
@@ -1,4 +1,5 @@
 #include "hardware.hpp"
+#include "common/fast_pin.hpp"
 #include "common/mock_arduino.hpp"
 
 #include "config.hpp"
@@ -19,35 +20,34 @@ void setup() {
 }
 
 void set_missile_leds(bool value) {
-  digitalWrite(pinout::MISSILE_LED, value); // Active high
+  fast_pin::FastPin<pinout::MISSILE_LED>::write(value); // Active high
 }
 
 void set_status_startup() {
-  digitalWrite(pinout::LED_RED, false);
-  digitalWrite(pinout::LED_GREEN, false);
-  digitalWrite(pinout::LED_BLUE, true);
+  fast_pin::FastPin<pinout::LED_RED>::write(false);
+  fast_pin::FastPin<pinout::LED_GREEN>::write(false);
+  fast_pin::FastPin<pinout::LED_BLUE>::write(true);
 }
 
 void set_status_connected() {
-  digitalWrite(pinout::LED_RED, false);
-  digitalWrite(pinout::LED_GREEN, true);
-  digitalWrite(pinout::LED_BLUE, false);
+  fast_pin::FastPin<pinout::LED_RED>::write(false);
+  fast_pin::FastPin<pinout::LED_GREEN>::write(true);
+  fast_pin::FastPin<pinout::LED_BLUE>::write(false);
 }
 
 void set_status_disconnected() {
-  digitalWrite(pinout::LED_RED, true);
-  digitalWrite(pinout::LED_GREEN, false);
-  digitalWrite(pinout::LED_BLUE, false);
+  fast_pin::FastPin<pinout::LED_RED>::write(true);
+  fast_pin::FastPin<pinout::LED_GREEN>::write(false);
+  fast_pin::FastPin<pinout::LED_BLUE>::write(false);
 }
 
 bool is_armed() {
   // Key switch pin gets pulled down to ground when the switch is active
-  return !digitalRead(pinout::KEY_SWITCH_IN);
+  return !fast_pin::FastPin<pinout::KEY_SWITCH_IN>::read();
 }
 
 uint8_t get_batt_dv() {
-  return (analogRead(pinout::BATT_VOLTAGE) + config::BATT_SCALE_PRE_OFFSET) *
-         config::BATT_SCALE_NUM / config::BATT_SCALE_DEN;
+  return config::BattDv::apply(analogRead(pinout::BATT_VOLTAGE));
 }
 
 } // namespace hardware
@@ -1,8 +1,6 @@
 #include "lcd.hpp"
 #include "common/mock_arduino.hpp"
 
-#include <stdio.h>
-
 #include "common/shared_types.hpp"
 #include "config.hpp"
 #include "hardware.hpp"
@@ -10,105 +8,227 @@
 
 namespace lcd {
 
+namespace {
+
+constexpr uint8_t COLS = 20;
+constexpr uint8_t ROWS = 4;
+// Each character costs the LCD about 200us over the 4 bit bus, so a flush is capped at this
+// many changed cells (plus cursor moves) and picks up where it left off next time
+constexpr uint8_t CELLS_PER_FLUSH = 4;
+constexpr uint8_t CURSOR_UNKNOWN = 0xFF;
+
 LiquidCrystal liquid_crystal{pinout::LCD_RS, pinout::LCD_EN, pinout::LCD_D4,
                              pinout::LCD_D5, pinout::LCD_D6, pinout::LCD_D7};
 
+// Rendering only touches this shadow of the screen in RAM. flush() then diffs it against what
+// was last sent to the LCD and writes only the cells that changed.
+class Screen {
+  char cells[ROWS * COLS];
+  uint8_t pos = 0;
+
+public:
+  Screen() {
+    memset(cells, ' ', sizeof(cells));
+  }
+
+  void setCursor(uint8_t col, uint8_t row) {
+    pos = row * COLS + col;
+  }
+
+  void print(char c) {
+    if (pos < sizeof(cells)) {
+      cells[pos++] = c;
+    }
+  }
+
+  void print(const char *str) {
+    while (*str) {
+      print(*str++);
+    }
+  }
+
+  char get(uint8_t i) const {
+    return cells[i];
+  }
+};
+
+Screen screen;
+char glass[ROWS * COLS]; // what is on the LCD
+uint8_t lcd_cursor = CURSOR_UNKNOWN; // where the LCD will put the next character
+uint8_t flush_pos = 0; // where the next flush starts looking for changes
+ErrorReport last_error = {}; // latest error towerside reported, count 0 until there is one
+
 void print_valve_position(uint16_t pos) {
   switch (pos) {
   case ActuatorPosition::ActuatorPosition::error:
-    liquid_crystal.print("ERR");
+    screen.print("ERR");
     break;
   case ActuatorPosition::ActuatorPosition::closed:
-    liquid_crystal.print("CLS");
+    screen.print("CLS");
     break;
   case ActuatorPosition::ActuatorPosition::open:
-    liquid_crystal.print("OPN");
+    screen.print("OPN");
     break;
   case ActuatorPosition::ActuatorPosition::unknown:
-    liquid_crystal.print("UNK");
+    screen.print("UNK");
     break;
   default:
-    liquid_crystal.print("???");
+    screen.print("???");
     break;
   }
 };
 
+// Three digits with leading zeros, saturating at 999
 void print_decimal_value(unsigned int num) {
-  char buf[4];
-  snprintf(buf, 4, "%03u", num);
-  liquid_crystal.print(buf);
+  if (num > 999) {
+    num = 999;
+  }
+  screen.print(static_cast<char>('0' + num / 100));
+  screen.print(static_cast<char>('0' + num / 10 % 10));
+  screen.print(static_cast<char>('0' + num % 10));
+}
+
+// Letter for the error code, then the device's address
+void print_error(const ErrorReport &error) {
+  if (error.count == 0) {
+    screen.print("---");
+    return;
+  }
+  switch (error.code) {
+  case ErrorCode::I2CWriteError:
+    screen.print('W');
+    break;
+  case ErrorCode::I2CReadError:
+    screen.print('R');
+    break;
+  case ErrorCode::OvercurrentTrip:
+    screen.print('O');
+    break;
+  case ErrorCode::ErrorTableFull:
+    screen.print('F');
+    break;
+  case ErrorCode::LogWriteError:
+    screen.print('L');
+    break;
+  case ErrorCode::HeaterLimitTrip:
+    screen.print('H');
+    break;
+  default:
+    screen.print('?');
+    break;
+  }
+  screen.print(static_cast<char>('0' + error.device / 10 % 10));
+  screen.print(static_cast<char>('0' + error.device % 10));
 }
 
+} // namespace
+
 void setup() {
-  liquid_crystal.begin(20, 4);
+  liquid_crystal.begin(COLS, ROWS);
   liquid_crystal.clear();
-  liquid_crystal.setCursor(2, 1);
-  liquid_crystal.print("Waiting for data");
-  liquid_crystal.setCursor(14, 3);
-  liquid_crystal.print("CB:");
+  memset(glass, ' ', sizeof(glass));
+  lcd_cursor = CURSOR_UNKNOWN;
+
+  screen.setCursor(2, 1);
+  screen.print("Waiting for data");
+  screen.setCursor(14, 3);
+  screen.print("CB:");
   print_decimal_value(hardware::get_batt_dv());
 }
 
+void flush() {
+  uint8_t written = 0;
+  for (uint8_t checked = 0; checked < sizeof(glass) && written < CELLS_PER_FLUSH; checked++) {
+    uint8_t i = flush_pos;
+    flush_pos = flush_pos + 1 == sizeof(glass) ? 0 : flush_pos + 1;
+    char c = screen.get(i);
+    if (glass[i] == c) {
+      continue;
+    }
+    if (lcd_cursor != i) {
+      liquid_crystal.setCursor(i % COLS, i / COLS);
+    }
+    liquid_crystal.print(c);
+    glass[i] = c;
+    written++;
+    // The LCD's address counter runs on along the row, but the rows aren't contiguous in its
+    // memory, so after the end of a row we don't know where it went
+    lcd_cursor = (i + 1) % COLS == 0 ? CURSOR_UNKNOWN : i + 1;
+  }
+}
+
 /* Layout:
    ----------------------
    |O1:OPN O2:CLS O3:UNK|
-   |IP:412 IS:456       | Those current are in hundredth(increment 0.01)
-   |E:000 CON:Y ARM:Y tH|
+   |IP:412 IS:456 T:025 | Those current are in hundredth(increment 0.01), T is tank heater 1 in degrees C
+   |E:W03 CON:Y ARM:Y tH| E is the latest error: W/R I2C write/read, O overcurrent, F error table full,
+   |                    |   L SD log, H heater limit, ? unknown code, then the board address. --- when none
    |TM:123 TA:118 CB:126| Those voltage are in tenth(increment 0.1)
    ----------------------
 */
 
 void update(SensorMessage msg) {
-  liquid_crystal.setCursor(0, 0);
-  liquid_crystal.print("O1:");
+  screen.setCursor(0, 0);
+  screen.print("O1:");
   print_valve_position(msg.ov101_state);
 
-  liquid_crystal.print(" O2:");
+  screen.print(" O2:");
   print_valve_position(msg.ov102_state);
 
-  liquid_crystal.print(" O3:");
+  screen.print(" O3:");
   print_valve_position(msg.ov103_state);
 
-  liquid_crystal.setCursor(0, 1);
+  screen.setCursor(0, 1);
 
-  liquid_crystal.print("IP:");
+  screen.print("IP:");
   print_decimal_value(msg.ignition_primary_ma / 10);
  
-  liquid_crystal.print(" IS:");
+  screen.print(" IS:");
   print_decimal_value(msg.ignition_secondary_ma / 10);
 
-  liquid_crystal.print("       ");
+  screen.print(" T:");
+  if (msg.heater_temp_dk_1 == SENSOR_ERR_VAL || msg.heater_temp_dk_1 < 2732) {
+    screen.print("---"); // no reading, or below 0C which doesn't fit
+  } else {
+    print_decimal_value((msg.heater_temp_dk_1 - 2732) / 10);
+  }
+  screen.print(" ");
 
-  liquid_crystal.setCursor(0, 2);
-  liquid_crystal.print("E:");
-  print_decimal_value(msg.error_code);
+  for (uint8_t i = 0; i < ERROR_REPORTS_PER_MESSAGE; i++) {
+    if (msg.errors.reports[i].count != 0) {
+      last_error = msg.errors.reports[i];
+    }
+  }
+  screen.setCursor(0, 2);
+  screen.print("E:");
+  print_error(last_error);
 
-  liquid_crystal.print(" CON:");
-  liquid_crystal.print(msg.has_contact ? "Y" : "N");
+  screen.print(" CON:");
+  screen.print(msg.has_contact ? 'Y' : 'N');
 
-  liquid_crystal.print(" ARM:");
-  liquid_crystal.print(msg.towerside_armed ? "Y" : "N");
+  screen.print(" ARM:");
+  screen.print(msg.towerside_armed ? 'Y' : 'N');
 
   if(msg.heater_kelvin_high_mv_1 >= 16000) {
-    liquid_crystal.print(" T");
+    screen.print(" T");
   }else{
-    liquid_crystal.print(" t");
+    screen.print(" t");
   }
 
   if(msg.heater_kelvin_high_mv_2 >= 16000) {
-    liquid_crystal.print("H");
+    screen.print("H");
   }else{
-    liquid_crystal.print("h");
+    screen.print("h");
   }
 
-  liquid_crystal.setCursor(0, 3);
-  liquid_crystal.print("TM:");
+  screen.setCursor(0, 3);
+  screen.print("TM:");
   print_decimal_value(msg.towerside_main_batt_mv / 100);
 
-  liquid_crystal.print(" TA:");
+  screen.print(" TA:");
   print_decimal_value(msg.towerside_actuator_batt_mv / 100);
 
-  liquid_crystal.print(" CB:");
+  screen.print(" CB:");
   print_decimal_value(hardware::get_batt_dv());
 }
 
@@ -6,7 +6,10 @@
 namespace lcd {
 
 void setup();
+// Renders the message into RAM, nothing is sent to the LCD until flush()
 void update(SensorMessage msg);
+// Sends a few changed characters to the LCD, call this every loop
+void flush();
 
 }; // namespace lcd
 
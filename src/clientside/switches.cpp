@@ -0,0 +1,106 @@
+#include "switches.hpp"
+#include "common/fast_pin.hpp"
+#include "common/mock_arduino.hpp"
+
+#include "pinout.hpp"
+
+namespace switches {
+
+#ifdef ARDUINO
+
+namespace {
+
+// A switch has to read the same for this many samples (ms) in a row to count
+constexpr uint8_t DEBOUNCE_SAMPLES = 5;
+
+// All of them are sampled together, five port reads in place of eight digitalReads
+typedef fast_pin::PortSnapshot<
+    pinout::MISSILE_SWITCH_1,
+    pinout::MISSILE_SWITCH_2,
+    pinout::MISSILE_SWITCH_6,
+    pinout::MISSILE_SWITCH_8,
+    pinout::MISSILE_SWITCH_INJECTOR,
+    pinout::MISSILE_SWITCH_IGNITION_PRI,
+    pinout::MISSILE_SWITCH_IGNITION_SEC,
+    pinout::MISSILE_SWITCH_IGNITION_FIRE>
+    Switches;
+constexpr uint8_t NUM_SWITCHES = 8;
+
+// Written from the timer interrupt
+volatile uint16_t debounced = 0; // bit per switch, in the order of Switches
+volatile bool changed = false;
+uint8_t counts[NUM_SWITCHES]; // interrupt only, samples the raw state has disagreed for
+
+} // namespace
+
+void handle_timer_interrupt() {
+  uint16_t state = debounced;
+  uint16_t raw_state = Switches().bits();
+  for (uint8_t i = 0; i < NUM_SWITCHES; i++) {
+    bool raw = raw_state & (1 << i);
+    bool current = state & (1 << i);
+    if (raw == current) {
+      counts[i] = 0;
+    } else if (++counts[i] >= DEBOUNCE_SAMPLES) {
+      counts[i] = 0;
+      state ^= 1 << i;
+      changed = true;
+    }
+  }
+  debounced = state;
+}
+
+void setup() {
+  // Start from the current positions, so nothing looks like a change on startup
+  debounced = Switches().bits();
+
+  // Timer3 in CTC mode at 1 kHz: 16 MHz / 64 / 250
+  TCCR3A = 0;
+  TCCR3B = (1 << WGM32) | (1 << CS31) | (1 << CS30);
+  OCR3A = 249;
+  TIMSK3 = (1 << OCIE3A);
+}
+
+bool read(uint8_t pin) {
+  int8_t index = Switches::index_of(pin);
+  if (index < 0) {
+    return digitalRead(pin);
+  }
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t state = debounced;
+  SREG = sreg;
+  return state & (1 << index);
+}
+
+bool take_changed() {
+  uint8_t sreg = SREG;
+  cli();
+  bool result = changed;
+  changed = false;
+  SREG = sreg;
+  return result;
+}
+
+#else
+
+// No timer interrupt on the host, read the pins directly and never report a change
+void setup() {}
+
+bool read(uint8_t pin) {
+  return digitalRead(pin);
+}
+
+bool take_changed() {
+  return false;
+}
+
+#endif
+
+} // namespace switches
+
+#ifdef ARDUINO
+ISR(TIMER3_COMPA_vect) {
+  switches::handle_timer_interrupt();
+}
+#endif
@@ -0,0 +1,21 @@
+#ifndef SWITCHES_HPP
+#define SWITCHES_HPP
+
+#include <stdint.h>
+
+// Debounced missile switches. None of the switch pins have pin change interrupts on the Mega,
+// so a 1 kHz timer interrupt samples them all and flags any debounced change, which lets the
+// main loop send a command as soon as a switch settles instead of on the next interval.
+namespace switches {
+
+void setup();
+
+// Debounced state of a missile switch pin, same as digitalRead on it
+bool read(uint8_t pin);
+
+// Whether any switch changed since the last call
+bool take_changed();
+
+} // namespace switches
+
+#endif
@@ -4,27 +4,37 @@
 #include "mock_arduino.hpp"
 #include <stdint.h>
 
-template <typename ST, typename RT> class Communicator {
-  Stream &stream;
+// Frames ST out and RT in as 'W' <struct bytes> 'R' '\n' over a serial port.
+//
+// The port type is a template parameter so every byte goes straight to the concrete port
+// instead of through Stream's virtual functions. The calls are qualified with Port:: because
+// HardwareSerial's functions are still virtual, and a qualified call skips the vtable and lets
+// the compiler inline what it can.
+template <typename ST, typename RT, typename Port = SerialPort> class Communicator {
+  Port &stream;
   static const size_t BUFF_SIZE = sizeof(RT) + 2;
   uint8_t receive_buffer[BUFF_SIZE];
 
   size_t buffer_position = 0;
   unsigned long time_of_last_byte = 0;
+  unsigned long time_of_last_frame = 0;
   const unsigned long reset_interval_ms;
 
 public:
-  Communicator(Stream &stream, unsigned long reset_interval_ms)
+  Communicator(Port &stream, unsigned long reset_interval_ms)
       : stream{stream}, reset_interval_ms{reset_interval_ms} {}
 
   void send(const ST &send_data) {
     const uint8_t *send_data_uint8 =
         reinterpret_cast<const uint8_t *>(&send_data);
 
-    stream.write('W');
-    stream.write(send_data_uint8, sizeof(ST));
-    stream.write('R');
-    stream.write('\n');
+    stream.Port::write('W');
+    // Byte by byte, the buffer overload is a loop of virtual calls on the Arduino anyway
+    for (size_t i = 0; i < sizeof(ST); i++) {
+      stream.Port::write(send_data_uint8[i]);
+    }
+    stream.Port::write('R');
+    stream.Port::write('\n');
   }
 
   bool get_message(RT *dest) {
@@ -39,17 +49,19 @@ public:
 
     memcpy(dest, receive_buffer + 1, sizeof(RT));
     buffer_position = 0;
+    time_of_last_frame = millis();
     return true;
   }
 
-  uint16_t seconds_since_last_contact() {
-    return (millis() - time_of_last_byte) / 1000;
+  // Time since the last correctly framed message, stray bytes and noise don't count as contact
+  unsigned long ms_since_last_frame() {
+    return millis() - time_of_last_frame;
   }
 
   bool read_byte() {
-    if (stream.available()) {
+    if (stream.Port::available()) {
       if (buffer_position < BUFF_SIZE) {
-        receive_buffer[buffer_position++] = static_cast<uint8_t>(stream.read());
+        receive_buffer[buffer_position++] = static_cast<uint8_t>(stream.Port::read());
       }
       time_of_last_byte = millis();
       return true;
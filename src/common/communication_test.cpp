@@ -12,6 +12,6 @@ void loop() {
   if (comm.get_message(&data)) {
     comm.send(data);
     std::cout << '\n';
-    std::cout << (int)comm.seconds_since_last_contact() << '\n';
+    std::cout << comm.ms_since_last_frame() << '\n';
   }
 }
@@ -36,14 +36,35 @@ struct ActuatorMessage {
 
 ActuatorMessage build_safe_state(const ActuatorMessage &current_state);
 
+// One (device, error code) pair that occurred again since the last message
+struct ErrorReport {
+  uint8_t device; // I2C address
+  ErrorCode::ErrorCode code;
+  uint16_t count; // since startup, saturates at 0xFFFF. 0 marks an empty slot
+  uint16_t active_s; // time from the first to the latest occurrence, saturates
+};
+
+const uint8_t ERROR_REPORTS_PER_MESSAGE = 3;
+
+struct ErrorSummary {
+  ErrorReport reports[ERROR_REPORTS_PER_MESSAGE];
+  uint8_t pending; // other errors that changed and will be reported in the next messages
+};
+
 struct SensorMessage {
   // Battery Voltages
   uint16_t towerside_main_batt_mv;
   uint16_t towerside_actuator_batt_mv;
+  // Battery sag and spikes since the last message
+  uint16_t towerside_main_batt_min_mv;
+  uint16_t towerside_main_batt_max_mv;
+  uint16_t towerside_actuator_batt_min_mv;
+  uint16_t towerside_actuator_batt_max_mv;
   // Actuator health
-  uint16_t error_code;
+  ErrorSummary errors;
   bool towerside_armed;
   bool has_contact;
+  uint16_t failsafe_latency_ms; // from the contact timeout to the safe state, last time it happened
   // Ignition currents
   uint16_t ignition_primary_ma;
   uint16_t ignition_secondary_ma;
@@ -51,9 +72,16 @@ struct SensorMessage {
   ActuatorPosition::ActuatorPosition ov101_state;
   ActuatorPosition::ActuatorPosition ov102_state;
   ActuatorPosition::ActuatorPosition ov103_state;
+  // Valve stroke times, SENSOR_ERR_VAL until the valve has made a full stroke
+  uint16_t ov101_open_ms;
+  uint16_t ov101_close_ms;
+  uint16_t ov102_open_ms;
+  uint16_t ov102_close_ms;
+  uint16_t ov103_open_ms;
+  uint16_t ov103_close_ms;
   // Tank Heating
-  uint16_t heater_thermistor_1;
-  uint16_t heater_thermistor_2;
+  uint16_t heater_temp_dk_1; // deci-Kelvin
+  uint16_t heater_temp_dk_2;
   uint16_t heater_current_ma_1;
   uint16_t heater_current_ma_2;
   uint16_t heater_batt_mv_1;
@@ -62,6 +90,8 @@ struct SensorMessage {
   uint16_t heater_kelvin_low_mv_2;
   uint16_t heater_kelvin_high_mv_1;
   uint16_t heater_kelvin_high_mv_2;
+  uint8_t heater_duty_1; // percent, 0xFF on error
+  uint8_t heater_duty_2;
 };
 #pragma pack(pop)
 
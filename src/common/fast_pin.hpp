@@ -0,0 +1,225 @@
+#ifndef FAST_PIN_H
+#define FAST_PIN_H
+
+#include <stdint.h>
+
+#include "mock_arduino.hpp"
+
+// GPIO for pins known at compile time, for the Mega2560 both stations run on.
+//
+// digitalRead/digitalWrite look the pin up in flash tables on every call (port, bit mask, timer
+// to turn off) and take a few microseconds each. FastPin<pinout::X> resolves the port and
+// mask at compile time, so a read or write is a single instruction for ports A to G. The
+// ports above the I/O space (H, J, K and L) have no single-instruction bit access, so writes
+// to them mask interrupts around the read-modify-write like digitalWrite does.
+//
+// PortSnapshot<pinout::X, pinout::Y, ...> reads each port the pins sit on once, so a group of
+// inputs is sampled at the same instant and at the cost of a few port reads.
+//
+// Both still expect pinMode to have been set up as usual. On the host both go through
+// digitalRead/digitalWrite from the mock.
+//
+// Usage:
+//   fast_pin::FastPin<pinout::LED_RED>::write(true);
+//   fast_pin::PortSnapshot<pinout::MISSILE_SWITCH_1, pinout::MISSILE_SWITCH_2> snapshot;
+//   bool first = snapshot.get<pinout::MISSILE_SWITCH_1>();
+//   uint16_t both = snapshot.bits(); // bit 0 is MISSILE_SWITCH_1
+namespace fast_pin {
+
+namespace detail {
+
+enum Port : uint8_t { PORT_A, PORT_B, PORT_C, PORT_D, PORT_E, PORT_F, PORT_G, PORT_H, PORT_J, PORT_K, PORT_L, NUM_PORTS };
+
+// Port in the top nibble, bit in the bottom one, indexed by Arduino pin number.
+// Same as digital_pin_to_port_PGM and digital_pin_to_bit_mask_PGM in the Mega variant.
+#define FAST_PIN_ENTRY(port, bit) static_cast<uint8_t>(PORT_##port << 4 | (bit))
+constexpr uint8_t PIN_MAP[] = {
+  FAST_PIN_ENTRY(E, 0), FAST_PIN_ENTRY(E, 1), FAST_PIN_ENTRY(E, 4), FAST_PIN_ENTRY(E, 5), // 0-3
+  FAST_PIN_ENTRY(G, 5), FAST_PIN_ENTRY(E, 3), FAST_PIN_ENTRY(H, 3), FAST_PIN_ENTRY(H, 4), // 4-7
+  FAST_PIN_ENTRY(H, 5), FAST_PIN_ENTRY(H, 6), FAST_PIN_ENTRY(B, 4), FAST_PIN_ENTRY(B, 5), // 8-11
+  FAST_PIN_ENTRY(B, 6), FAST_PIN_ENTRY(B, 7), FAST_PIN_ENTRY(J, 1), FAST_PIN_ENTRY(J, 0), // 12-15
+  FAST_PIN_ENTRY(H, 1), FAST_PIN_ENTRY(H, 0), FAST_PIN_ENTRY(D, 3), FAST_PIN_ENTRY(D, 2), // 16-19
+  FAST_PIN_ENTRY(D, 1), FAST_PIN_ENTRY(D, 0), FAST_PIN_ENTRY(A, 0), FAST_PIN_ENTRY(A, 1), // 20-23
+  FAST_PIN_ENTRY(A, 2), FAST_PIN_ENTRY(A, 3), FAST_PIN_ENTRY(A, 4), FAST_PIN_ENTRY(A, 5), // 24-27
+  FAST_PIN_ENTRY(A, 6), FAST_PIN_ENTRY(A, 7), FAST_PIN_ENTRY(C, 7), FAST_PIN_ENTRY(C, 6), // 28-31
+  FAST_PIN_ENTRY(C, 5), FAST_PIN_ENTRY(C, 4), FAST_PIN_ENTRY(C, 3), FAST_PIN_ENTRY(C, 2), // 32-35
+  FAST_PIN_ENTRY(C, 1), FAST_PIN_ENTRY(C, 0), FAST_PIN_ENTRY(D, 7), FAST_PIN_ENTRY(G, 2), // 36-39
+  FAST_PIN_ENTRY(G, 1), FAST_PIN_ENTRY(G, 0), FAST_PIN_ENTRY(L, 7), FAST_PIN_ENTRY(L, 6), // 40-43
+  FAST_PIN_ENTRY(L, 5), FAST_PIN_ENTRY(L, 4), FAST_PIN_ENTRY(L, 3), FAST_PIN_ENTRY(L, 2), // 44-47
+  FAST_PIN_ENTRY(L, 1), FAST_PIN_ENTRY(L, 0), FAST_PIN_ENTRY(B, 3), FAST_PIN_ENTRY(B, 2), // 48-51
+  FAST_PIN_ENTRY(B, 1), FAST_PIN_ENTRY(B, 0), FAST_PIN_ENTRY(F, 0), FAST_PIN_ENTRY(F, 1), // 52-55
+  FAST_PIN_ENTRY(F, 2), FAST_PIN_ENTRY(F, 3), FAST_PIN_ENTRY(F, 4), FAST_PIN_ENTRY(F, 5), // 56-59
+  FAST_PIN_ENTRY(F, 6), FAST_PIN_ENTRY(F, 7), FAST_PIN_ENTRY(K, 0), FAST_PIN_ENTRY(K, 1), // 60-63
+  FAST_PIN_ENTRY(K, 2), FAST_PIN_ENTRY(K, 3), FAST_PIN_ENTRY(K, 4), FAST_PIN_ENTRY(K, 5), // 64-67
+  FAST_PIN_ENTRY(K, 6), FAST_PIN_ENTRY(K, 7), // 68-69
+};
+#undef FAST_PIN_ENTRY
+constexpr uint8_t NUM_PINS = sizeof(PIN_MAP) / sizeof(PIN_MAP[0]);
+
+constexpr Port port_of(uint8_t pin) {
+  return static_cast<Port>(PIN_MAP[pin] >> 4);
+}
+
+constexpr uint8_t mask_of(uint8_t pin) {
+  return 1 << (PIN_MAP[pin] & 0x0F);
+}
+
+// Spot checks against the pinouts
+static_assert(port_of(20) == PORT_D && mask_of(20) == 1 << 1, "pin map is off");
+static_assert(port_of(6) == PORT_H && mask_of(6) == 1 << 3, "pin map is off");
+static_assert(port_of(43) == PORT_L && mask_of(43) == 1 << 6, "pin map is off");
+static_assert(port_of(64) == PORT_K && mask_of(64) == 1 << 2, "pin map is off");
+
+#ifdef ARDUINO
+
+// Ports H and up are only reachable with lds/sts, so no sbi/cbi
+constexpr bool is_extended(Port port) {
+  return port >= PORT_H;
+}
+
+template <Port P> struct Registers;
+
+#define FAST_PIN_REGISTERS(port)                            \
+  template <> struct Registers<PORT_##port> {                   \
+    static volatile uint8_t &in() { return PIN##port; }     \
+    static volatile uint8_t &out() { return PORT##port; }   \
+  };
+FAST_PIN_REGISTERS(A)
+FAST_PIN_REGISTERS(B)
+FAST_PIN_REGISTERS(C)
+FAST_PIN_REGISTERS(D)
+FAST_PIN_REGISTERS(E)
+FAST_PIN_REGISTERS(F)
+FAST_PIN_REGISTERS(G)
+FAST_PIN_REGISTERS(H)
+FAST_PIN_REGISTERS(J)
+FAST_PIN_REGISTERS(K)
+FAST_PIN_REGISTERS(L)
+#undef FAST_PIN_REGISTERS
+
+#endif
+
+// Bit per port used by any of the pins
+template <uint8_t... PINS> struct PortsUsed;
+template <> struct PortsUsed<> {
+  static constexpr uint16_t value = 0;
+};
+template <uint8_t PIN, uint8_t... REST> struct PortsUsed<PIN, REST...> {
+  static constexpr uint16_t value = 1 << port_of(PIN) | PortsUsed<REST...>::value;
+};
+
+} // namespace detail
+
+template <uint8_t PIN>
+class FastPin {
+  static_assert(PIN < detail::NUM_PINS, "not a Mega2560 pin");
+
+public:
+  static constexpr detail::Port PORT_ID = detail::port_of(PIN);
+  static constexpr uint8_t MASK = detail::mask_of(PIN);
+
+#ifdef ARDUINO
+  static bool read() {
+    return detail::Registers<PORT_ID>::in() & MASK;
+  }
+
+  static void write(bool value) {
+    if (detail::is_extended(PORT_ID)) {
+      uint8_t sreg = SREG;
+      cli();
+      set(value);
+      SREG = sreg;
+    } else {
+      set(value);
+    }
+  }
+
+private:
+  static void set(bool value) {
+    if (value) {
+      detail::Registers<PORT_ID>::out() |= MASK;
+    } else {
+      detail::Registers<PORT_ID>::out() &= ~MASK;
+    }
+  }
+#else
+  static bool read() {
+    return digitalRead(PIN);
+  }
+
+  static void write(bool value) {
+    digitalWrite(PIN, value);
+  }
+#endif
+};
+
+template <uint8_t... PINS>
+class PortSnapshot {
+  static_assert(sizeof...(PINS) <= 16, "bits() only holds 16 pins");
+
+#ifdef ARDUINO
+  static constexpr uint16_t PORTS = detail::PortsUsed<PINS...>::value;
+
+  uint8_t ports[detail::NUM_PORTS];
+
+  template <detail::Port P> void sample() {
+    if (PORTS & (1 << P)) {
+      ports[P] = detail::Registers<P>::in();
+    }
+  }
+#endif
+
+  template <uint8_t PIN> uint16_t bits_from() const {
+    return get<PIN>();
+  }
+  template <uint8_t PIN, uint8_t NEXT, uint8_t... REST> uint16_t bits_from() const {
+    return get<PIN>() | bits_from<NEXT, REST...>() << 1;
+  }
+
+public:
+#ifdef ARDUINO
+  // Only the ports in use are read, the rest of the array is left alone
+  PortSnapshot() {
+    sample<detail::PORT_A>();
+    sample<detail::PORT_B>();
+    sample<detail::PORT_C>();
+    sample<detail::PORT_D>();
+    sample<detail::PORT_E>();
+    sample<detail::PORT_F>();
+    sample<detail::PORT_G>();
+    sample<detail::PORT_H>();
+    sample<detail::PORT_J>();
+    sample<detail::PORT_K>();
+    sample<detail::PORT_L>();
+  }
+
+  template <uint8_t PIN> bool get() const {
+    static_assert(PORTS & (1 << detail::port_of(PIN)), "pin isn't part of the snapshot");
+    return ports[detail::port_of(PIN)] & detail::mask_of(PIN);
+  }
+#else
+  template <uint8_t PIN> bool get() const {
+    return digitalRead(PIN);
+  }
+#endif
+
+  // Every pin in the order given, first pin in bit 0
+  uint16_t bits() const {
+    return bits_from<PINS...>();
+  }
+
+  // Position of the pin in the order given, -1 if it isn't one of them
+  static int8_t index_of(uint8_t pin) {
+    const uint8_t pins[] = {PINS...};
+    for (uint8_t i = 0; i < sizeof...(PINS); i++) {
+      if (pins[i] == pin) {
+        return i;
+      }
+    }
+    return -1;
+  }
+};
+
+} // namespace fast_pin
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stdint.h>
+
+#include "config.hpp"
+
+// Layout of towerside's onboard log (LOGnnn.BIN on the SD card).
+//
+// The file is a sequence of BLOCK_SIZE blocks, which line up with the card's sectors. Every
+// block starts with a BlockHeader and is followed by `used` bytes of records, then zero padding.
+// Records never straddle blocks, so any block can be decoded on its own.
+//
+// A record is a RecordHeader and `length` bytes of payload, whose layout depends on the type.
+// Readers should skip types they don't know using the length. All fields are little endian,
+// the same as the AVR's memory layout.
+namespace log_format {
+
+const uint16_t BLOCK_SIZE = 512;
+const uint32_t BLOCK_MAGIC = 0x474F4C52; // "RLOG" at the start of every block
+// Bump whenever a record layout changes, including SensorMessage and ActuatorMessage
+const uint8_t VERSION = 1;
+
+; // random semicolon to fix clangd warning bug, see common/config.hpp
+#pragma pack(push, 1)
+struct BlockHeader {
+  uint32_t magic;
+  uint32_t sequence; // blocks since the logger started, counts up from 0 in every file
+  uint16_t used; // bytes of records following the header
+  uint8_t version;
+  uint8_t records;
+  uint16_t dropped; // records lost just before this block because the buffers were full
+};
+
+const uint16_t BLOCK_DATA_SIZE = BLOCK_SIZE - sizeof(BlockHeader);
+
+enum RecordType : uint8_t {
+  RECORD_STATUS = 1, // StatusRecord, sampled at STATUS_INTERVAL_MS
+  RECORD_SENSORS = 2, // SensorMessage, each one sent to clientside
+  RECORD_COMMAND = 3, // ActuatorMessage, whenever the command applied to the actuators changes
+};
+
+struct RecordHeader {
+  RecordType type;
+  uint8_t length; // payload bytes after this header
+  uint32_t time_ms; // towerside's millis()
+};
+
+const uint8_t STATUS_ARMED = 1 << 0;
+const uint8_t STATUS_CONTACT = 1 << 1;
+const uint8_t STATUS_FAILSAFE_TRIPPED = 1 << 2;
+
+// The readings towerside has without going over I2C
+struct StatusRecord {
+  uint16_t main_batt_mv;
+  uint16_t actuator_batt_mv;
+  uint8_t flags; // STATUS_*
+};
+#pragma pack(pop)
+
+const uint16_t STATUS_INTERVAL_MS = 10;
+
+static_assert(sizeof(BlockHeader) == 14, "block header layout changed, bump VERSION");
+static_assert(sizeof(SensorMessage) <= 0xFF && sizeof(RecordHeader) + sizeof(SensorMessage) <= BLOCK_DATA_SIZE,
+              "sensor message doesn't fit in a record");
+
+} // namespace log_format
+
+#endif
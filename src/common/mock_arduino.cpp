@@ -9,6 +9,7 @@ MockSerial Serial;
 MockSerial Serial2;
 MockSerial Serial3;
 TwoWire Wire;
+SDClass SD;
 
 unsigned long millis() {
   static unsigned long n;
@@ -5,41 +5,30 @@
 
 #ifndef ARDUINO
 
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <stdint.h>
-#include <cstring>
-
-class Stream {
-public:
-  virtual bool available() = 0;
-  virtual char read() = 0;
-  virtual bool write(char c __unused) = 0;
-  bool write(const uint8_t *c, size_t len) {
-    bool output = true;
-    for (size_t i = 0; i < len; ++i) {
-      output &= write(*(c + i));
-    }
-    return output;
-  }
-};
 
-class MockSerial : public Stream {
+// Stands in for HardwareSerial, without the virtual functions since Communicator binds to
+// the port type at compile time
+class MockSerial {
 public:
   MockSerial() {
     std::cin >> std::noskipws;
   }
   void begin(int baud __unused) {}
-  bool available() override {
+  int available() {
     return true;
   }
-  char read() override {
+  int read() {
     char c = 0;
     std::cin >> c;
-    return c;
+    return static_cast<uint8_t>(c);
   }
-  bool write(char c) override {
-    std::cout << c;
-    return true;
+  size_t write(uint8_t c) {
+    std::cout << static_cast<char>(c);
+    return 1;
   }
 
   template <typename T> void print(T t) {
@@ -47,6 +36,8 @@ public:
   }
 };
 
+typedef MockSerial SerialPort;
+
 extern MockSerial Serial;
 extern MockSerial Serial2;
 extern MockSerial Serial3;
@@ -95,6 +86,54 @@ public:
   void setCursor(uint8_t col __unused, uint8_t row __unused) {}
 };
 
+// The SD library, backed by files in the working directory
+#define FILE_READ 0
+#define FILE_WRITE 1
+
+class File {
+  FILE *file = nullptr;
+
+public:
+  File() {}
+  File(FILE *file) : file{file} {}
+  size_t write(const uint8_t *buf, size_t size) {
+    return file ? fwrite(buf, 1, size, file) : 0;
+  }
+  void flush() {
+    if (file) {
+      fflush(file);
+    }
+  }
+  void close() {
+    if (file) {
+      fclose(file);
+      file = nullptr;
+    }
+  }
+  operator bool() const {
+    return file != nullptr;
+  }
+};
+
+class SDClass {
+public:
+  bool begin(uint8_t cs_pin __unused) {
+    return true;
+  }
+  bool exists(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file) {
+      fclose(file);
+    }
+    return file != nullptr;
+  }
+  File open(const char *path, uint8_t mode = FILE_READ) {
+    return File(fopen(path, mode == FILE_WRITE ? "ab" : "rb"));
+  }
+};
+
+extern SDClass SD;
+
 unsigned long millis();
 uint16_t analogRead(uint8_t);
 bool digitalRead(uint8_t);
@@ -104,14 +143,21 @@ void pinMode(uint8_t, bool);
 #define INPUT_PULLUP true
 #define OUTPUT false
 
-int main();
+// Flash and RAM are one address space on the host
+#define PROGMEM
+inline uint16_t pgm_read_word(const uint16_t *address) {
+  return *address;
+}
 
 #else
 
 #include <Arduino.h>
 #include <LiquidCrystal.h>
+#include <SD.h>
 #include <Wire.h>
 
+typedef HardwareSerial SerialPort;
+
 #endif
 
 #endif
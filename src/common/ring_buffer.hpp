@@ -0,0 +1,149 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+
+// Single producer, single consumer queue that needs no locks, so one side can be an interrupt
+// (or, on the host, another thread) while the other is the main loop.
+//
+// The producer only ever writes head and the consumer only ever writes tail. Each side fills
+// or empties a slot before publishing its index with a release store, and the other side reads
+// it with an acquire load, so it can't see the index move before the slot contents. The indices
+// are single bytes, which the AVR loads and stores in one instruction, so none of this needs
+// interrupts masked. They run freely and wrap at 256, which is why CAPACITY is at most 128,
+// and slots are found by masking with CAPACITY - 1, which is why it's a power of two.
+//
+// Besides push/pop of single items, the span functions hand out the contiguous run of free or
+// filled slots up to the end of the array, to copy a block in or out in one go:
+//   RingBuffer<uint8_t, 64> buffer;
+//   RingBuffer<uint8_t, 64>::Span span = buffer.read_span();
+//   size_t written = file.write(span.data, span.length);
+//   buffer.consume(written);
+template <typename T, uint8_t CAPACITY>
+class RingBuffer {
+  static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+  static_assert(CAPACITY <= 128, "capacity must leave the byte indices room to wrap");
+
+  static constexpr uint8_t MASK = CAPACITY - 1;
+
+  T items[CAPACITY];
+  uint8_t head = 0; // next slot to fill, producer only
+  uint8_t tail = 0; // next slot to empty, consumer only
+
+  static uint8_t load(const uint8_t &index) {
+    return __atomic_load_n(&index, __ATOMIC_ACQUIRE);
+  }
+
+  static void store(uint8_t &index, uint8_t value) {
+    __atomic_store_n(&index, value, __ATOMIC_RELEASE);
+  }
+
+  static uint8_t min(uint8_t a, uint8_t b) {
+    return a < b ? a : b;
+  }
+
+public:
+  struct Span {
+    T *data;
+    uint8_t length;
+  };
+
+  // Either side, the result may already be stale by the time it's used
+  uint8_t size() const {
+    return static_cast<uint8_t>(load(head) - load(tail));
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  static constexpr uint8_t capacity() {
+    return CAPACITY;
+  }
+
+  // Producer side
+
+  bool push(const T &item) {
+    uint8_t h = head;
+    if (static_cast<uint8_t>(h - load(tail)) == CAPACITY) {
+      return false;
+    }
+    items[h & MASK] = item;
+    store(head, h + 1);
+    return true;
+  }
+
+  // Pushes as many as fit, returns how many that was
+  uint8_t push(const T *src, uint8_t count) {
+    uint8_t pushed = 0;
+    while (pushed < count) {
+      Span span = write_span();
+      if (span.length == 0) {
+        break;
+      }
+      uint8_t n = min(span.length, static_cast<uint8_t>(count - pushed));
+      for (uint8_t i = 0; i < n; i++) {
+        span.data[i] = src[pushed + i];
+      }
+      commit(n);
+      pushed += n;
+    }
+    return pushed;
+  }
+
+  // Free slots from head up to the end of the array, fill some of them and commit() them
+  Span write_span() {
+    uint8_t h = head;
+    uint8_t unused = CAPACITY - static_cast<uint8_t>(h - load(tail));
+    uint8_t to_end = CAPACITY - (h & MASK);
+    return Span{&items[h & MASK], min(unused, to_end)};
+  }
+
+  void commit(uint8_t count) {
+    store(head, head + count);
+  }
+
+  // Consumer side
+
+  bool pop(T *item) {
+    uint8_t t = tail;
+    if (load(head) == t) {
+      return false;
+    }
+    *item = items[t & MASK];
+    store(tail, t + 1);
+    return true;
+  }
+
+  // Pops up to count, returns how many there were
+  uint8_t pop(T *dest, uint8_t count) {
+    uint8_t popped = 0;
+    while (popped < count) {
+      Span span = read_span();
+      if (span.length == 0) {
+        break;
+      }
+      uint8_t n = min(span.length, static_cast<uint8_t>(count - popped));
+      for (uint8_t i = 0; i < n; i++) {
+        dest[popped + i] = span.data[i];
+      }
+      consume(n);
+      popped += n;
+    }
+    return popped;
+  }
+
+  // Filled slots from tail up to the end of the array, use some of them and consume() them
+  Span read_span() {
+    uint8_t t = tail;
+    uint8_t filled = static_cast<uint8_t>(load(head) - t);
+    uint8_t to_end = CAPACITY - (t & MASK);
+    return Span{&items[t & MASK], min(filled, to_end)};
+  }
+
+  void consume(uint8_t count) {
+    store(tail, tail + count);
+  }
+};
+
+#endif
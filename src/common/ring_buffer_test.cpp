@@ -0,0 +1,116 @@
+// Runs a producer and a consumer thread through a small ring buffer and checks every item
+// arrives once and in order, mixing single items, bulk copies and spans on both sides.
+// g++ -std=gnu++11 -Wall -Wextra -O2 -pthread ring_buffer_test.cpp -o ring_buffer_test && ./ring_buffer_test
+#include "ring_buffer.hpp"
+#include <iostream>
+#include <thread>
+
+const uint32_t ITEMS = 2000000;
+
+typedef RingBuffer<uint32_t, 16> Buffer;
+
+bool check_single_thread() {
+  Buffer buffer;
+  uint32_t item = 0;
+  bool ok = buffer.empty() && !buffer.pop(&item);
+  for (uint32_t i = 0; i < Buffer::capacity(); i++) {
+    ok &= buffer.push(i);
+  }
+  ok &= !buffer.push(99) && buffer.size() == Buffer::capacity() && buffer.write_span().length == 0;
+
+  // Move head and tail off the start, so the spans have to stop at the end of the array
+  uint32_t out[Buffer::capacity()];
+  ok &= buffer.pop(out, 10) == 10 && out[9] == 9;
+  uint32_t in[] = {100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111};
+  ok &= buffer.push(in, 12) == 10; // only 10 free
+  ok &= buffer.read_span().length == 6; // 10..15, then it wraps
+  ok &= buffer.pop(out, Buffer::capacity()) == Buffer::capacity();
+  ok &= out[0] == 10 && out[5] == 15 && out[6] == 100 && out[15] == 109 && buffer.empty();
+  std::cout << "single thread: " << (ok ? "ok" : "failed") << '\n';
+  return ok;
+}
+
+bool check_threads() {
+  Buffer buffer;
+
+  std::thread producer([&buffer]() {
+    uint32_t next = 0;
+    while (next < ITEMS) {
+      if (buffer.size() == Buffer::capacity()) {
+        std::this_thread::yield(); // lets the consumer in when the threads share a core
+      }
+      switch (next % 3) {
+      case 0:
+        if (buffer.push(next)) {
+          next++;
+        }
+        break;
+      case 1: {
+        uint32_t block[5];
+        uint8_t count = ITEMS - next < 5 ? ITEMS - next : 5;
+        for (uint8_t i = 0; i < count; i++) {
+          block[i] = next + i;
+        }
+        next += buffer.push(block, count);
+        break;
+      }
+      default: {
+        Buffer::Span span = buffer.write_span();
+        uint8_t count = 0;
+        for (; count < span.length && next < ITEMS; count++) {
+          span.data[count] = next++;
+        }
+        buffer.commit(count);
+        break;
+      }
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  bool ok = true;
+  while (expected < ITEMS) {
+    if (buffer.empty()) {
+      std::this_thread::yield();
+    }
+    uint32_t block[7];
+    uint8_t count = 0;
+    switch (expected % 3) {
+    case 0:
+      count = buffer.pop(block);
+      break;
+    case 1:
+      count = buffer.pop(block, 7);
+      break;
+    default: {
+      Buffer::Span span = buffer.read_span();
+      count = span.length < 7 ? span.length : 7;
+      for (uint8_t i = 0; i < count; i++) {
+        block[i] = span.data[i];
+      }
+      buffer.consume(count);
+      break;
+    }
+    }
+    for (uint8_t i = 0; i < count; i++) {
+      if (block[i] != expected && ok) {
+        std::cout << "threads: got " << block[i] << ", expected " << expected << '\n';
+        ok = false;
+      }
+      // Keep draining after a mismatch so the producer can finish
+      expected = block[i] + 1;
+    }
+  }
+
+  producer.join();
+  ok &= buffer.empty();
+  std::cout << "threads: " << (ok ? "ok" : "failed") << '\n';
+  return ok;
+}
+
+int main() {
+  bool ok = true;
+  ok &= check_single_thread();
+  ok &= check_threads();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#ifndef SCALE_H
+#define SCALE_H
+
+#include <stdint.h>
+
+#include "shared_types.hpp"
+
+// Compile-time rational scaling for sensor conversions:
+//   out = (in + PRE_OFFSET) * NUM / DEN, rounded down and saturated to [0, OUT_MAX]
+// The cheapest way to do that on an 8-bit AVR is worked out by the compiler: a shift for
+// powers of two, a multiply for integers, a multiply and shift for power of two
+// denominators, and otherwise a multiply by a fixed-point reciprocal and shift that is exact
+// for every input up to MAX_IN. Division is only used if no exact reciprocal fits in 32 bits.
+// The intermediate type is the narrowest one that provably can't overflow.
+//
+// Inputs are clamped to MAX_IN, so keep it at the real range of the reading (1023 for the
+// Arduino's ADC, 4095 for the 12 bit heater readings, ...).
+//
+// Usage:
+//   typedef scale::Scale<1023, 240, 17> BattMv; // adc * 5V / 1024 * 48 / 17 divider
+//   uint16_t mv = BattMv::apply(analogRead(pin));
+namespace scale {
+
+namespace detail {
+
+constexpr uint64_t gcd(uint64_t a, uint64_t b) {
+  return b == 0 ? a : gcd(b, a % b);
+}
+
+constexpr bool is_pow2(uint64_t x) {
+  return x != 0 && (x & (x - 1)) == 0;
+}
+
+constexpr uint8_t log2(uint64_t x) {
+  return x <= 1 ? 0 : 1 + log2(x >> 1);
+}
+
+// Reciprocal multiplier for x * num / den ~= (x * multiplier) >> shift. It rounds up, so the
+// approximation only ever errs high, by x * error / (den << shift).
+constexpr uint64_t multiplier(uint64_t num, uint64_t den, uint8_t shift) {
+  return ((num << shift) + den - 1) / den;
+}
+
+constexpr uint64_t error(uint64_t num, uint64_t den, uint8_t shift) {
+  return multiplier(num, den, shift) * den - (num << shift);
+}
+
+// The fractional part of x * num / den is at most (den - 1) / den, so the floor can't change
+// as long as the error stays under 1 / den, that is max_in * error < 2^shift. Returns the
+// smallest such shift, or 0 if the product would no longer fit in 32 bits first.
+constexpr uint8_t reciprocal_shift(uint64_t max_in, uint64_t num, uint64_t den, uint8_t shift) {
+  return max_in * multiplier(num, den, shift) > 0xFFFFFFFF ? 0
+       : max_in * error(num, den, shift) < (1ULL << shift) ? shift
+       : reciprocal_shift(max_in, num, den, shift + 1);
+}
+
+enum Method : uint8_t {
+  SHIFT_LEFT, // x << shift
+  MULTIPLY, // x * num
+  MULTIPLY_SHIFT, // (x * multiplier) >> shift, also covers power of two denominators
+  DIVIDE, // x * num / den
+};
+
+template <Method M> struct Tag {};
+
+// Narrowest unsigned type holding max
+template <bool FITS_16> struct Wide {
+  typedef uint16_t type;
+};
+template <> struct Wide<false> {
+  typedef uint32_t type;
+};
+
+} // namespace detail
+
+template <uint16_t MAX_IN, uint32_t NUM, uint32_t DEN, int32_t PRE_OFFSET = 0, uint16_t OUT_MAX = SENSOR_ERR_VAL - 1>
+class Scale {
+  static_assert(NUM > 0 && DEN > 0, "scale factor must be positive");
+  static_assert(static_cast<int32_t>(MAX_IN) + PRE_OFFSET > 0, "offset leaves nothing of the input range");
+
+  // Largest value after the offset
+  static constexpr uint64_t MAX_OFFSET = static_cast<uint64_t>(static_cast<int32_t>(MAX_IN) + PRE_OFFSET);
+
+  static constexpr uint64_t N = NUM / detail::gcd(NUM, DEN);
+  static constexpr uint64_t D = DEN / detail::gcd(NUM, DEN);
+  static constexpr uint8_t RECIPROCAL_SHIFT = detail::reciprocal_shift(MAX_OFFSET, N, D, 0);
+
+  static constexpr detail::Method METHOD =
+      D == 1 ? (detail::is_pow2(N) ? detail::SHIFT_LEFT : detail::MULTIPLY)
+    : detail::is_pow2(D) ? detail::MULTIPLY_SHIFT
+    : RECIPROCAL_SHIFT != 0 ? detail::MULTIPLY_SHIFT
+    : detail::DIVIDE;
+
+  // Power of two denominators are an exact reciprocal with no error
+  static constexpr uint8_t SHIFT =
+      D == 1 ? detail::log2(N) : detail::is_pow2(D) ? detail::log2(D) : RECIPROCAL_SHIFT;
+  static constexpr uint64_t MULTIPLIER = detail::is_pow2(D) ? N : detail::multiplier(N, D, SHIFT);
+
+  // Largest intermediate value of the chosen method
+  static constexpr uint64_t MAX_PRODUCT =
+      METHOD == detail::SHIFT_LEFT || METHOD == detail::MULTIPLY ? MAX_OFFSET * N
+    : METHOD == detail::MULTIPLY_SHIFT ? MAX_OFFSET * MULTIPLIER
+    : MAX_OFFSET * N;
+  static_assert(MAX_PRODUCT <= 0xFFFFFFFF, "scale factor overflows 32 bits over the input range");
+
+  static constexpr bool SATURATES = MAX_OFFSET * N / D > OUT_MAX;
+
+  typedef typename detail::Wide<MAX_PRODUCT <= 0xFFFF>::type Wide;
+
+  static Wide op(Wide x, detail::Tag<detail::SHIFT_LEFT>) {
+    return x << SHIFT;
+  }
+  static Wide op(Wide x, detail::Tag<detail::MULTIPLY>) {
+    return x * static_cast<Wide>(N);
+  }
+  static Wide op(Wide x, detail::Tag<detail::MULTIPLY_SHIFT>) {
+    return (x * static_cast<Wide>(MULTIPLIER)) >> SHIFT;
+  }
+  static Wide op(Wide x, detail::Tag<detail::DIVIDE>) {
+    return x * static_cast<Wide>(N) / static_cast<Wide>(D);
+  }
+
+public:
+  static uint16_t apply(uint16_t in) {
+    if (in > MAX_IN) {
+      in = MAX_IN;
+    }
+    if (PRE_OFFSET < 0 && static_cast<int32_t>(in) + PRE_OFFSET <= 0) {
+      return 0;
+    }
+    Wide out = op(static_cast<Wide>(static_cast<int32_t>(in) + PRE_OFFSET), detail::Tag<METHOD>());
+    if (SATURATES && out > OUT_MAX) {
+      return OUT_MAX;
+    }
+    return out;
+  }
+
+  // Passes SENSOR_ERR_VAL through instead of clamping it
+  static uint16_t apply_or_err(uint16_t in) {
+    return in == SENSOR_ERR_VAL ? SENSOR_ERR_VAL : apply(in);
+  }
+};
+
+} // namespace scale
+
+#endif
@@ -0,0 +1,40 @@
+// Checks every input of the scales used on the stations against plain 64 bit math.
+// g++ -std=gnu++11 -Wall -Wextra scale_test.cpp -o scale_test && ./scale_test
+#include "scale.hpp"
+#include <iostream>
+
+template <typename S, uint16_t MAX_IN, uint32_t NUM, uint32_t DEN, int32_t PRE_OFFSET, uint16_t OUT_MAX>
+bool check(const char *name) {
+  for (uint32_t in = 0; in <= 0xFFFF; in++) {
+    int64_t x = static_cast<int64_t>(in > MAX_IN ? MAX_IN : in) + PRE_OFFSET;
+    int64_t expected = x <= 0 ? 0 : x * NUM / DEN;
+    if (expected > OUT_MAX) {
+      expected = OUT_MAX;
+    }
+    uint16_t actual = S::apply(static_cast<uint16_t>(in));
+    if (actual != expected) {
+      std::cout << name << ": " << in << " gave " << actual << ", expected " << expected << '\n';
+      return false;
+    }
+  }
+  std::cout << name << ": ok\n";
+  return true;
+}
+
+#define CHECK(MAX_IN, NUM, DEN, PRE_OFFSET, OUT_MAX)                                               \
+  check<scale::Scale<MAX_IN, NUM, DEN, PRE_OFFSET, OUT_MAX>, MAX_IN, NUM, DEN, PRE_OFFSET, OUT_MAX>( \
+      "(" #MAX_IN " + " #PRE_OFFSET ") * " #NUM " / " #DEN)
+
+int main() {
+  bool ok = true;
+  ok &= CHECK(1023, 4, 1, 0, 0xFFFE); // shift
+  ok &= CHECK(4095, 10, 1, 0, 0xFFFE); // multiply
+  ok &= CHECK(4095, 176, 25, 0, 0xFFFE); // reciprocal
+  ok &= CHECK(1023, 240, 17, 0, 0xFFFE); // reciprocal
+  ok &= CHECK(255, 16, 1, 0, 0xFFFE); // shift
+  ok &= CHECK(1023, 1, 7, -11, 0xFF); // negative offset, narrow output
+  ok &= CHECK(1023, 5, 8, 0, 0xFFFE); // power of two denominator
+  ok &= CHECK(65535, 3, 1, 0, 0xFFFE); // saturates
+  ok &= CHECK(65535, 1000, 997, 0, 0xFFFE); // no exact reciprocal fits, divides
+  return ok ? 0 : 1;
+}
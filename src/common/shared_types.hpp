@@ -17,6 +17,10 @@ namespace ErrorCode {
 enum ErrorCode: uint8_t {
   I2CWriteError,
   I2CReadError,
+  OvercurrentTrip,
+  ErrorTableFull, // reported for device 0 with the count of errors that weren't tracked
+  LogWriteError, // device 0, the SD card is missing or stopped taking writes
+  HeaterLimitTrip, // a heater board hit its current or kelvin limit and turned the heater off
 };
 } // namespace ErrorCode
 
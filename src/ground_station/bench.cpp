@@ -0,0 +1,220 @@
+// Throughput benchmark for the recorder, and a check that it records what it's sent.
+//
+//   ground_station_bench [pty|file] [frames]
+//
+// Generates frames numbered in sensor_msg.towerside_main_batt_mv, with every CORRUPT_EVERY-th
+// one damaged and some noise between frames, and feeds them through a pty (the same path as a
+// real serial port) or from a file as fast as the recorder will take them. Reports the rate
+// against clientside's real one and fails if the recording has anything other than the good
+// frames in order.
+//
+// The frames are published to telemetry readers at the same time, one keeping up as best it
+// can and one deliberately slow. Both have to see frames in order and account for every frame
+// as read or missed, and neither may hold up the recorder.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "recorder.hpp"
+#include "serial.hpp"
+
+namespace {
+
+const size_t CORRUPT_EVERY = 97;
+const size_t NOISE_EVERY = 31;
+const double CLIENTSIDE_FRAMES_PER_S = 1000.0 / config::COMMAND_MESSAGE_INTERVAL_MS;
+// The slow reader sleeps a millisecond every this many frames
+const uint64_t SLOW_READER_BATCH = 16;
+
+std::vector<uint8_t> make_stream(size_t frames, size_t *good) {
+  std::vector<uint8_t> stream;
+  *good = 0;
+  for (size_t i = 0; i < frames; i++) {
+    config::USBMessage message = {};
+    message.sensor_msg.towerside_main_batt_mv = static_cast<uint16_t>(i);
+    // A telemetry reader checks these two agree to catch frames torn by the publisher
+    message.sensor_msg.towerside_actuator_batt_mv = static_cast<uint16_t>(~i);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&message);
+    stream.push_back('W');
+    stream.insert(stream.end(), bytes, bytes + sizeof(message));
+    bool corrupt = i % CORRUPT_EVERY == CORRUPT_EVERY - 1;
+    stream.push_back(corrupt ? 'X' : 'R');
+    stream.push_back('\n');
+    *good += corrupt ? 0 : 1;
+    if (i % NOISE_EVERY == 0) {
+      stream.insert(stream.end(), {'W', 'R', '\n', 0x00, 0xFF});
+    }
+  }
+  return stream;
+}
+
+// Every recorded entry has to be a good frame, in order. Dropped ones may be missing.
+bool check_recording(FILE *output, size_t frames) {
+  fseek(output, sizeof(recording::FileHeader), SEEK_SET);
+  recording::Entry entry;
+  size_t next = 0;
+  uint64_t last_time = 0;
+  while (fread(&entry, sizeof(entry), 1, output) == 1) {
+    while (next < frames && (next % CORRUPT_EVERY == CORRUPT_EVERY - 1 ||
+                             static_cast<uint16_t>(next) != entry.message.sensor_msg.towerside_main_batt_mv)) {
+      next++;
+    }
+    if (next == frames || entry.host_time_us < last_time) {
+      return false;
+    }
+    last_time = entry.host_time_us;
+    next++;
+  }
+  return true;
+}
+
+struct Follower {
+  std::unique_ptr<telemetry::Subscriber> subscriber;
+  uint64_t read = 0;
+  bool in_order = true;
+  std::thread thread;
+};
+
+// Reads until the feed is over and nothing is left, checking frames are whole and in order
+void follow(Follower *follower, bool slow, const std::atomic<bool> *feed_done) {
+  telemetry::Frame frame;
+  uint16_t last = 0;
+  while (true) {
+    bool done = feed_done->load(std::memory_order_acquire);
+    if (!follower->subscriber->next(&frame)) {
+      if (done) {
+        return;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    uint16_t number = frame.message.sensor_msg.towerside_main_batt_mv;
+    if (frame.message.sensor_msg.towerside_actuator_batt_mv != static_cast<uint16_t>(~number) ||
+        (follower->read > 0 && static_cast<uint16_t>(number - last) >= 0x8000)) {
+      follower->in_order = false;
+    }
+    last = number;
+    follower->read++;
+    if (slow && follower->read % SLOW_READER_BATCH == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+int run(const std::string &mode, size_t frames) {
+  size_t good;
+  std::vector<uint8_t> stream = make_stream(frames, &good);
+
+  FILE *output = tmpfile();
+  if (output == nullptr) {
+    throw std::runtime_error("can't create a temporary recording");
+  }
+  prepare_recording(output);
+
+  int input;
+  int feed = -1;
+  if (mode == "pty") {
+    feed = posix_openpt(O_RDWR | O_NOCTTY);
+    if (feed < 0 || grantpt(feed) != 0 || unlockpt(feed) != 0) {
+      throw std::runtime_error("can't create a pty");
+    }
+    input = serial::open_input(ptsname(feed), 115200);
+  } else if (mode == "file") {
+    char path[] = "/tmp/ground_station_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, stream.data(), stream.size()) != static_cast<ssize_t>(stream.size())) {
+      throw std::runtime_error("can't write the input file");
+    }
+    close(fd);
+    input = serial::open_input(path, 115200);
+    unlink(path);
+  } else {
+    std::cerr << "usage: ground_station_bench [pty|file] [frames]\n";
+    return 2;
+  }
+
+  std::string shm_name = "/rlcs_telemetry_bench_" + std::to_string(getpid());
+  telemetry::Publisher publisher(shm_name);
+  std::atomic<bool> feed_done{false};
+  Follower followers[2];
+  for (int i = 0; i < 2; i++) {
+    followers[i].subscriber.reset(new telemetry::Subscriber(shm_name));
+    followers[i].thread = std::thread(follow, &followers[i], i == 1, &feed_done);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  // A pty can be filled far faster than any serial port, waiting when full measures the rate
+  // the recorder can keep up with instead of how much of a burst fits in its queue
+  Recorder recorder(input, output, true);
+  recorder.publish_to(&publisher);
+  recorder.start();
+  if (feed >= 0) {
+    for (size_t sent = 0; sent < stream.size();) {
+      ssize_t n = write(feed, stream.data() + sent, std::min<size_t>(4096, stream.size() - sent));
+      if (n < 0) {
+        throw std::runtime_error("can't write to the pty");
+      }
+      sent += n;
+    }
+    // Closing the pty could throw away whatever the recorder hasn't read yet
+    while (recorder.bytes_read() < stream.size()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    recorder.stop();
+  }
+  recorder.wait();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  feed_done.store(true, std::memory_order_release);
+
+  bool ok = recorder.frames() == good && recorder.written() + recorder.dropped() == good &&
+            !recorder.write_failed() && check_recording(output, frames);
+  bool followers_ok = true;
+  for (Follower &follower : followers) {
+    follower.thread.join();
+    followers_ok &= follower.in_order && follower.read + follower.subscriber->missed() == good;
+  }
+  printf("%s: %zu frames (%zu good, %.1f MB) in %.3f s\n", mode.c_str(), frames, good, stream.size() / 1e6,
+         seconds);
+  printf("%.0f frames/s, %.0fx clientside's %.0f frames/s\n", good / seconds,
+         good / seconds / CLIENTSIDE_FRAMES_PER_S, CLIENTSIDE_FRAMES_PER_S);
+  printf("%llu written, %llu bad, %llu dropped, %llu bytes skipped: %s\n",
+         static_cast<unsigned long long>(recorder.written()), static_cast<unsigned long long>(recorder.bad_frames()),
+         static_cast<unsigned long long>(recorder.dropped()),
+         static_cast<unsigned long long>(recorder.skipped_bytes()), ok ? "OK" : "FAILED");
+  const char *names[] = {"fast", "slow"};
+  for (int i = 0; i < 2; i++) {
+    printf("%s telemetry reader: %llu read, %llu missed%s\n", names[i],
+           static_cast<unsigned long long>(followers[i].read),
+           static_cast<unsigned long long>(followers[i].subscriber->missed()),
+           followers[i].in_order ? "" : ", TORN OR OUT OF ORDER");
+  }
+  printf("telemetry: %s\n", followers_ok ? "OK" : "FAILED");
+
+  close(input);
+  if (feed >= 0) {
+    close(feed);
+  }
+  fclose(output);
+  return ok && followers_ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    return run(argc > 1 ? argv[1] : "pty", argc > 2 ? std::stoul(argv[2]) : 200000);
+  } catch (const std::exception &e) {
+    std::cerr << "ground_station_bench: " << e.what() << '\n';
+    return 1;
+  }
+}
@@ -0,0 +1,11 @@
+#include "frame_decoder.hpp"
+
+void FrameDecoder::resync() {
+  size_t next = 1;
+  while (next < filled && buffer[next] != 'W') {
+    next++;
+  }
+  skipped += next;
+  filled -= next;
+  memmove(buffer, buffer + next, filled);
+}
@@ -0,0 +1,76 @@
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "../clientside/config.hpp"
+
+// Pulls config::USBMessage frames ('W' <message> 'R' '\n') out of a byte stream that can start
+// mid-frame and lose or corrupt bytes along the way.
+//
+// A frame is only accepted if its trailer is in the right place. When it isn't, the leading 'W'
+// was noise or the frame was damaged, so decoding restarts from the next 'W' already buffered
+// rather than after the bad frame, which could be hiding the start of a good one.
+class FrameDecoder {
+public:
+  static const size_t FRAME_SIZE = sizeof(config::USBMessage) + 3;
+
+  // Calls on_frame(const config::USBMessage &) for every frame completed by these bytes
+  template <typename OnFrame> void feed(const uint8_t *data, size_t length, OnFrame on_frame) {
+    size_t i = 0;
+    while (i < length) {
+      if (filled == 0) {
+        const void *start = memchr(data + i, 'W', length - i);
+        if (start == nullptr) {
+          skipped += length - i;
+          return;
+        }
+        size_t at = static_cast<const uint8_t *>(start) - data;
+        skipped += at - i;
+        i = at;
+      }
+      size_t n = FRAME_SIZE - filled < length - i ? FRAME_SIZE - filled : length - i;
+      memcpy(buffer + filled, data + i, n);
+      filled += n;
+      i += n;
+      if (filled < FRAME_SIZE) {
+        return;
+      }
+      if (buffer[FRAME_SIZE - 2] == 'R' && buffer[FRAME_SIZE - 1] == '\n') {
+        config::USBMessage message;
+        memcpy(&message, buffer + 1, sizeof(message));
+        filled = 0;
+        frames++;
+        on_frame(message);
+      } else {
+        bad_frames++;
+        resync();
+      }
+    }
+  }
+
+  uint64_t frame_count() const {
+    return frames;
+  }
+  // Frames thrown away because their trailer was wrong
+  uint64_t bad_frame_count() const {
+    return bad_frames;
+  }
+  // Bytes that weren't part of any good frame
+  uint64_t skipped_bytes() const {
+    return skipped;
+  }
+
+private:
+  uint8_t buffer[FRAME_SIZE];
+  size_t filled = 0;
+  uint64_t frames = 0;
+  uint64_t bad_frames = 0;
+  uint64_t skipped = 0;
+
+  void resync();
+};
+
+#endif
@@ -0,0 +1,112 @@
+// Records clientside's USB output to disk and shares it live with other local programs.
+//
+//   ground_station <device> <recording> [--baud N] [--shm NAME | --no-shm]
+//
+// device is normally clientside's /dev/ttyACM*, but a capture file, FIFO or pty works too.
+// Frames are appended to recording with the host time they arrived, see recording.hpp;
+// log_tool reads the result. They're also published to the shared memory ring NAME
+// (telemetry::DEFAULT_NAME unless given), see telemetry.hpp; telemetry_tail reads that.
+// Runs until the device goes away or it gets SIGINT/SIGTERM, printing counters to stderr every
+// STATUS_INTERVAL_S.
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "recorder.hpp"
+#include "serial.hpp"
+
+namespace {
+
+const unsigned DEFAULT_BAUD = 115200; // clientside's Serial.begin()
+const int STATUS_INTERVAL_S = 10;
+
+void print_status(const Recorder &recorder) {
+  std::cerr << recorder.frames() << " frames, " << recorder.written() << " written, " << recorder.bad_frames()
+            << " bad, " << recorder.dropped() << " dropped, " << recorder.skipped_bytes() << " bytes skipped"
+            << (recorder.write_failed() ? ", WRITE FAILED" : "") << '\n';
+}
+
+int run(int argc, char **argv) {
+  std::string device;
+  std::string path;
+  unsigned baud = DEFAULT_BAUD;
+  std::string shm_name = telemetry::DEFAULT_NAME;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--baud" && i + 1 < argc) {
+      baud = std::stoul(argv[++i]);
+    } else if (arg == "--shm" && i + 1 < argc) {
+      shm_name = argv[++i];
+    } else if (arg == "--no-shm") {
+      shm_name.clear();
+    } else if (device.empty()) {
+      device = arg;
+    } else if (path.empty()) {
+      path = arg;
+    } else {
+      device.clear();
+      break;
+    }
+  }
+  if (device.empty() || path.empty()) {
+    std::cerr << "usage: ground_station <device> <recording> [--baud N] [--shm NAME | --no-shm]\n";
+    return 2;
+  }
+
+  int input = serial::open_input(device, baud);
+  FILE *output = fopen(path.c_str(), "a+b");
+  if (output == nullptr) {
+    throw std::runtime_error("can't open " + path + ": " + strerror(errno));
+  }
+  prepare_recording(output);
+  std::unique_ptr<telemetry::Publisher> publisher;
+  if (!shm_name.empty()) {
+    publisher.reset(new telemetry::Publisher(shm_name));
+  }
+
+  // Only this thread takes the signals, the recorder's threads inherit the mask
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  // A capture file can be read faster than it's written, a live port can't be held up
+  Recorder recorder(input, output, !isatty(input));
+  recorder.publish_to(publisher.get());
+  recorder.start();
+  time_t last_status = time(nullptr);
+  while (!recorder.finished()) {
+    struct timespec timeout = {1, 0};
+    if (sigtimedwait(&signals, nullptr, &timeout) > 0) {
+      recorder.stop();
+    }
+    if (time(nullptr) - last_status >= STATUS_INTERVAL_S) {
+      print_status(recorder);
+      last_status = time(nullptr);
+    }
+  }
+  recorder.wait();
+  print_status(recorder);
+
+  close(input);
+  bool failed = fclose(output) != 0 || recorder.write_failed();
+  return failed ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    return run(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << "ground_station: " << e.what() << '\n';
+    return 1;
+  }
+}
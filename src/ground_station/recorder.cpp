@@ -0,0 +1,164 @@
+#include "recorder.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const int POLL_TIMEOUT_MS = 100;
+const auto FLUSH_INTERVAL = std::chrono::seconds(1);
+const auto IDLE_SLEEP = std::chrono::milliseconds(1);
+// Times the writer checks the queue again straight away after emptying it, before sleeping
+const int BUSY_POLLS = 100;
+
+uint64_t host_time_us() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+} // namespace
+
+Recorder::Recorder(int input, FILE *output, bool wait_when_full)
+    : input{input}, output{output}, wait_when_full{wait_when_full} {}
+
+Recorder::~Recorder() {
+  stop();
+  wait();
+}
+
+void Recorder::publish_to(telemetry::Publisher *live) {
+  publisher = live;
+}
+
+void Recorder::start() {
+  reader = std::thread(&Recorder::read_loop, this);
+  writer = std::thread(&Recorder::write_loop, this);
+}
+
+void Recorder::wait() {
+  if (reader.joinable()) {
+    reader.join();
+  }
+  if (writer.joinable()) {
+    writer.join();
+  }
+}
+
+void Recorder::stop() {
+  stopping.store(true, std::memory_order_relaxed);
+}
+
+void Recorder::read_loop() {
+  uint8_t chunk[4096];
+  while (!stopping.load(std::memory_order_relaxed)) {
+    // Wake up now and then even if the port is quiet, to notice stop()
+    struct pollfd fds = {input, POLLIN, 0};
+    int ready = poll(&fds, 1, POLL_TIMEOUT_MS);
+    if (ready == 0 || (ready < 0 && errno == EINTR)) {
+      continue;
+    }
+    ssize_t length = ready < 0 ? -1 : read(input, chunk, sizeof(chunk));
+    if (length < 0 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    }
+    if (length <= 0) {
+      // End of a file, or the port went away (a pty or USB device reports EIO once closed)
+      break;
+    }
+    // Every frame finished by this read gets the same timestamp, the bytes arrived together
+    uint64_t now = host_time_us();
+    decoder.feed(chunk, length, [&](const config::USBMessage &message) {
+      recording::Entry entry = {now, message};
+      if (publisher != nullptr) {
+        publisher->publish(entry);
+      }
+      while (!queue.push(entry)) {
+        if (!wait_when_full || stopping.load(std::memory_order_relaxed)) {
+          dropped_frames.fetch_add(1, std::memory_order_relaxed);
+          return;
+        }
+        // The writer is busy emptying it, so give it the CPU rather than sleeping
+        std::this_thread::yield();
+      }
+    });
+    read_bytes.fetch_add(length, std::memory_order_relaxed);
+    decoded.store(decoder.frame_count(), std::memory_order_relaxed);
+    bad.store(decoder.bad_frame_count(), std::memory_order_relaxed);
+    skipped.store(decoder.skipped_bytes(), std::memory_order_relaxed);
+  }
+  input_done.store(true, std::memory_order_release);
+}
+
+void Recorder::write_loop() {
+  auto last_flush = std::chrono::steady_clock::now();
+  int idle = 0;
+  while (true) {
+    // Checked before looking at the queue, so whatever the reader pushed before finishing is seen
+    bool finished = input_done.load(std::memory_order_acquire);
+    RingBuffer<recording::Entry, QUEUE_SIZE>::Span span = queue.read_span();
+    if (span.length > 0) {
+      // Entries are laid out exactly as in the file, so a run of them goes out in one call
+      size_t count = fwrite(span.data, sizeof(recording::Entry), span.length, output);
+      queue.consume(span.length);
+      written_frames.fetch_add(count, std::memory_order_relaxed);
+      if (count < span.length) {
+        write_error.store(true, std::memory_order_relaxed);
+      }
+      idle = 0;
+    } else if (finished) {
+      break;
+    } else if (++idle < BUSY_POLLS) {
+      // More is likely on the way during a burst, sleeping now would let the queue fill
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_flush >= FLUSH_INTERVAL) {
+      if (fflush(output) != 0) {
+        write_error.store(true, std::memory_order_relaxed);
+      }
+      last_flush = now;
+    }
+  }
+  if (fflush(output) != 0) {
+    write_error.store(true, std::memory_order_relaxed);
+  }
+  output_done.store(true, std::memory_order_release);
+}
+
+void prepare_recording(FILE *output) {
+  struct stat st;
+  if (fstat(fileno(output), &st) != 0) {
+    throw std::runtime_error(std::string("can't stat the recording: ") + strerror(errno));
+  }
+  if (st.st_size == 0) {
+    recording::FileHeader header = {recording::MAGIC, recording::VERSION, sizeof(recording::Entry)};
+    if (fwrite(&header, sizeof(header), 1, output) != 1 || fflush(output) != 0) {
+      throw std::runtime_error(std::string("can't write the recording header: ") + strerror(errno));
+    }
+    return;
+  }
+  recording::FileHeader header;
+  rewind(output);
+  if (fread(&header, sizeof(header), 1, output) != 1 || header.magic != recording::MAGIC) {
+    throw std::runtime_error("not a ground station recording");
+  }
+  if (header.version != recording::VERSION || header.entry_size != sizeof(recording::Entry)) {
+    throw std::runtime_error("recording is from a different message layout, start a new one");
+  }
+  // Drop an entry cut off by a crash, so the new ones line up
+  off_t entries = (st.st_size - sizeof(header)) / sizeof(recording::Entry);
+  off_t whole = sizeof(header) + entries * sizeof(recording::Entry);
+  if (whole != st.st_size && ftruncate(fileno(output), whole) != 0) {
+    throw std::runtime_error(std::string("can't trim the recording: ") + strerror(errno));
+  }
+  fseek(output, 0, SEEK_END);
+}
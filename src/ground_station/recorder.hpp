@@ -0,0 +1,100 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "common/ring_buffer.hpp"
+#include "frame_decoder.hpp"
+#include "recording.hpp"
+#include "telemetry.hpp"
+
+// Records clientside's USB output with two threads, so a slow disk never holds up the port.
+//
+// The reader thread reads the input, decodes frames, timestamps them and pushes them onto a
+// lock-free queue. The writer thread takes them off in contiguous runs and appends those straight
+// to the output, flushing at least once a second. The queue holds QUEUE_SIZE frames, over ten
+// seconds of clientside's output; if the writer still falls that far behind, new frames are
+// counted as dropped rather than making the reader wait, unless wait_when_full is set, which is
+// for inputs that can't overrun like a capture file.
+//
+// With publish_to(), the reader thread also publishes every frame to live readers as soon as
+// it's decoded, which never waits on them.
+class Recorder {
+public:
+  static const uint8_t QUEUE_SIZE = 128;
+
+  // output must be positioned at the end of a recording (after its header, if new)
+  Recorder(int input, FILE *output, bool wait_when_full);
+  ~Recorder();
+  Recorder(const Recorder &) = delete;
+  Recorder &operator=(const Recorder &) = delete;
+
+  // Call before start()
+  void publish_to(telemetry::Publisher *live);
+  void start();
+  // Returns once the input has ended or stop() was called, and everything read is written
+  void wait();
+  // Safe from any thread, the reader notices within 100ms
+  void stop();
+  // True once wait() wouldn't block
+  bool finished() const {
+    return output_done.load(std::memory_order_acquire);
+  }
+
+  // Live counters, safe to read from any thread
+  uint64_t bytes_read() const {
+    return read_bytes.load(std::memory_order_relaxed);
+  }
+  uint64_t frames() const {
+    return decoded.load(std::memory_order_relaxed);
+  }
+  uint64_t bad_frames() const {
+    return bad.load(std::memory_order_relaxed);
+  }
+  uint64_t skipped_bytes() const {
+    return skipped.load(std::memory_order_relaxed);
+  }
+  uint64_t dropped() const {
+    return dropped_frames.load(std::memory_order_relaxed);
+  }
+  uint64_t written() const {
+    return written_frames.load(std::memory_order_relaxed);
+  }
+  bool write_failed() const {
+    return write_error.load(std::memory_order_relaxed);
+  }
+
+private:
+  const int input;
+  FILE *const output;
+  const bool wait_when_full;
+  telemetry::Publisher *publisher = nullptr;
+
+  RingBuffer<recording::Entry, QUEUE_SIZE> queue;
+  FrameDecoder decoder;
+  std::thread reader;
+  std::thread writer;
+
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> input_done{false};
+  std::atomic<bool> output_done{false};
+  std::atomic<uint64_t> read_bytes{0};
+  std::atomic<uint64_t> decoded{0};
+  std::atomic<uint64_t> bad{0};
+  std::atomic<uint64_t> skipped{0};
+  std::atomic<uint64_t> dropped_frames{0};
+  std::atomic<uint64_t> written_frames{0};
+  std::atomic<bool> write_error{false};
+
+  void read_loop();
+  void write_loop();
+};
+
+// Writes the header if output is empty, otherwise checks it's a recording this build can extend.
+// Leaves output at the end either way. Throws if it's something else.
+void prepare_recording(FILE *output);
+
+#endif
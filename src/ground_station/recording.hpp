@@ -0,0 +1,35 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <stdint.h>
+
+#include "../clientside/config.hpp"
+
+// Layout of the ground station's recordings of clientside's USB output.
+//
+// A FileHeader, then one Entry per frame received. Entries are a fixed size, so the nth one is
+// at sizeof(FileHeader) + n * sizeof(Entry) and a cut off last entry is easy to spot. Restarting
+// the recorder on the same file appends more entries after the existing ones.
+namespace recording {
+
+const uint32_t MAGIC = 0x43455252; // "RREC"
+// Bump whenever Entry changes, including SensorMessage and ActuatorMessage
+const uint16_t VERSION = 1;
+
+; // random semicolon to fix clangd warning bug, see common/config.hpp
+#pragma pack(push, 1)
+struct FileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t entry_size; // sizeof(Entry) when written, to refuse files from a different layout
+};
+
+struct Entry {
+  uint64_t host_time_us; // CLOCK_REALTIME when the frame's last byte was read
+  config::USBMessage message;
+};
+#pragma pack(pop)
+
+} // namespace recording
+
+#endif
@@ -0,0 +1,63 @@
+#include "serial.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <termios.h>
+#include <unistd.h>
+
+namespace serial {
+
+namespace {
+
+speed_t to_speed(unsigned baud) {
+  switch (baud) {
+  case 9600:
+    return B9600;
+  case 19200:
+    return B19200;
+  case 38400:
+    return B38400;
+  case 57600:
+    return B57600;
+  case 115200:
+    return B115200;
+  case 230400:
+    return B230400;
+  default:
+    throw std::invalid_argument("unsupported baud rate " + std::to_string(baud));
+  }
+}
+
+} // namespace
+
+int open_input(const std::string &path, unsigned baud) {
+  speed_t speed = to_speed(baud);
+  int fd = open(path.c_str(), O_RDONLY | O_NOCTTY);
+  if (fd < 0) {
+    throw std::runtime_error("can't open " + path + ": " + strerror(errno));
+  }
+  if (!isatty(fd)) {
+    return fd;
+  }
+  struct termios tty;
+  if (tcgetattr(fd, &tty) != 0) {
+    close(fd);
+    throw std::runtime_error("can't read the settings of " + path + ": " + strerror(errno));
+  }
+  cfmakeraw(&tty);
+  cfsetispeed(&tty, speed);
+  cfsetospeed(&tty, speed);
+  tty.c_cflag |= CLOCAL | CREAD;
+  // Block until at least one byte is there, then return whatever has arrived
+  tty.c_cc[VMIN] = 1;
+  tty.c_cc[VTIME] = 0;
+  if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+    close(fd);
+    throw std::runtime_error("can't configure " + path + ": " + strerror(errno));
+  }
+  return fd;
+}
+
+} // namespace serial
@@ -0,0 +1,14 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <string>
+
+namespace serial {
+
+// Opens path for reading. A terminal (clientside's /dev/ttyACM*, or a pty) is put in raw mode
+// at baud; anything else, like a capture file or a FIFO, is read as it is. Throws on failure.
+int open_input(const std::string &path, unsigned baud);
+
+} // namespace serial
+
+#endif
@@ -0,0 +1,157 @@
+#include "telemetry.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace telemetry {
+
+namespace {
+
+bool is_running(int32_t pid) {
+  return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// Maps an existing ring and checks it's one this build understands, or returns nullptr
+const Ring *map_ring(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  void *mapping = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Ring)) {
+    mapping = mmap(nullptr, sizeof(Ring), PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  const Ring *ring = static_cast<const Ring *>(mapping);
+  if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != MAGIC || ring->version != VERSION ||
+      ring->slot_count != SLOTS || ring->frame_size != sizeof(Frame)) {
+    munmap(mapping, sizeof(Ring));
+    return nullptr;
+  }
+  return ring;
+}
+
+} // namespace
+
+Publisher::Publisher(const std::string &name) : name{name} {
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0 && errno == EEXIST) {
+    const Ring *old = map_ring(name);
+    bool in_use = old != nullptr && !old->closed.load(std::memory_order_relaxed) && is_running(old->publisher_pid);
+    int32_t old_pid = old != nullptr ? old->publisher_pid : 0;
+    if (old != nullptr) {
+      munmap(const_cast<Ring *>(old), sizeof(Ring));
+    }
+    if (in_use) {
+      throw std::runtime_error(name + " is already published by pid " + std::to_string(old_pid));
+    }
+    // Left behind by a crash, or from a different build
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  }
+  if (fd < 0) {
+    throw std::runtime_error("can't create shared memory " + name + ": " + strerror(errno));
+  }
+  void *mapping = MAP_FAILED;
+  if (ftruncate(fd, sizeof(Ring)) == 0) {
+    mapping = mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int error = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    throw std::runtime_error("can't map shared memory " + name + ": " + strerror(error));
+  }
+  // A new mapping is all zeros, which is already an empty ring
+  ring = static_cast<Ring *>(mapping);
+  ring->version = VERSION;
+  ring->slot_count = SLOTS;
+  ring->frame_size = sizeof(Frame);
+  ring->publisher_pid = getpid();
+  __atomic_store_n(&ring->magic, MAGIC, __ATOMIC_RELEASE);
+}
+
+Publisher::~Publisher() {
+  ring->closed.store(1, std::memory_order_release);
+  munmap(ring, sizeof(Ring));
+  shm_unlink(name.c_str());
+}
+
+void Publisher::publish(const Frame &frame) {
+  uint64_t words[Slot::WORDS] = {};
+  memcpy(words, &frame, sizeof(frame));
+  Slot &slot = ring->slots[next % SLOTS];
+  slot.sequence.store(2 * next + 1, std::memory_order_relaxed);
+  // Readers mustn't see any of the new words without also seeing the odd sequence
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < Slot::WORDS; i++) {
+    __atomic_store_n(&slot.words[i], words[i], __ATOMIC_RELAXED);
+  }
+  slot.sequence.store(2 * next + 2, std::memory_order_release);
+  next++;
+  ring->published.store(next, std::memory_order_release);
+}
+
+Subscriber::Subscriber(const std::string &name) : ring{map_ring(name)} {
+  if (ring == nullptr) {
+    throw std::runtime_error("nothing is publishing telemetry on " + name);
+  }
+  wanted = ring->published.load(std::memory_order_acquire);
+}
+
+Subscriber::~Subscriber() {
+  munmap(const_cast<Ring *>(ring), sizeof(Ring));
+}
+
+bool Subscriber::next(Frame *frame) {
+  while (true) {
+    const Slot &slot = ring->slots[wanted % SLOTS];
+    const uint64_t done = 2 * wanted + 2;
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before < done) {
+      return false; // not published yet, or being written right now
+    }
+    if (before == done) {
+      uint64_t words[Slot::WORDS];
+      for (size_t i = 0; i < Slot::WORDS; i++) {
+        words[i] = __atomic_load_n(&slot.words[i], __ATOMIC_RELAXED);
+      }
+      // The words must be read before checking the sequence again
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == done) {
+        memcpy(frame, words, sizeof(*frame));
+        wanted++;
+        return true;
+      }
+    }
+    // Lapped, skip to halfway around the ring so there's room to catch up before it happens again
+    uint64_t published = ring->published.load(std::memory_order_acquire);
+    uint64_t resume = published > SLOTS / 2 ? published - SLOTS / 2 : 0;
+    if (resume <= wanted) {
+      resume = wanted + 1;
+    }
+    missed_frames += resume - wanted;
+    wanted = resume;
+  }
+}
+
+uint64_t Subscriber::backlog() const {
+  uint64_t published = ring->published.load(std::memory_order_acquire);
+  return published > wanted ? published - wanted : 0;
+}
+
+bool Subscriber::publisher_closed() const {
+  return ring->closed.load(std::memory_order_acquire) != 0 || !is_running(ring->publisher_pid);
+}
+
+} // namespace telemetry
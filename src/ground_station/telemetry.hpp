@@ -0,0 +1,99 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "recording.hpp"
+
+// Live fan-out of decoded frames to any number of local processes (dashboards, alarm checkers)
+// through a POSIX shared memory ring, so only the ground station has to own the serial port.
+//
+// The publisher writes frame n into slot n % SLOTS and never waits for anyone. Each slot is a
+// seqlock: its sequence is 2n + 1 while frame n is being written and 2n + 2 once it's done. A
+// reader wanting frame n copies the slot out and keeps the copy only if the sequence was 2n + 2
+// both before and after. A larger sequence means the publisher has lapped the reader, which then
+// skips ahead and counts the frames it missed. Readers only map the ring read-only, so nothing
+// they do can disturb the publisher or each other.
+namespace telemetry {
+
+const char DEFAULT_NAME[] = "/rlcs_telemetry";
+const uint32_t MAGIC = 0x4D485352; // "RSHM"
+const uint32_t VERSION = 1;
+// Power of two, about 100s of clientside's output
+const uint32_t SLOTS = 1024;
+
+// A frame as published, the same as the recorder writes to disk
+typedef recording::Entry Frame;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must not need a lock");
+
+struct alignas(64) Slot {
+  static const size_t WORDS = (sizeof(Frame) + 7) / 8;
+
+  std::atomic<uint64_t> sequence;
+  // The frame, copied in and out a word at a time with atomic accesses so a reader racing the
+  // publisher reads stale or mixed words rather than undefined behaviour, and then discards them
+  uint64_t words[WORDS];
+};
+
+struct Ring {
+  uint32_t magic; // stored last when creating, readers check it to know the ring is ready
+  uint32_t version;
+  uint32_t slot_count;
+  uint32_t frame_size;
+  int32_t publisher_pid;
+  alignas(64) std::atomic<uint64_t> published; // frames published so far
+  std::atomic<uint32_t> closed; // set when the publisher exits cleanly
+  Slot slots[SLOTS];
+};
+
+class Publisher {
+public:
+  // Creates the ring, replacing one left behind by a publisher that's no longer running.
+  // Throws if another publisher is using the name.
+  explicit Publisher(const std::string &name = DEFAULT_NAME);
+  // Marks the ring closed and removes the name, readers already attached keep their mapping
+  ~Publisher();
+  Publisher(const Publisher &) = delete;
+  Publisher &operator=(const Publisher &) = delete;
+
+  // Only ever called from one thread
+  void publish(const Frame &frame);
+
+private:
+  std::string name;
+  Ring *ring;
+  uint64_t next = 0;
+};
+
+class Subscriber {
+public:
+  // Attaches to a running publisher's ring, and starts at the next frame published. Throws if
+  // there is none.
+  explicit Subscriber(const std::string &name = DEFAULT_NAME);
+  ~Subscriber();
+  Subscriber(const Subscriber &) = delete;
+  Subscriber &operator=(const Subscriber &) = delete;
+
+  // Copies out the next frame and returns true, or returns false if it isn't published yet.
+  // Frames overwritten before this reader got to them are skipped and added to missed().
+  bool next(Frame *frame);
+
+  uint64_t missed() const {
+    return missed_frames;
+  }
+  // Frames published but not read yet
+  uint64_t backlog() const;
+  bool publisher_closed() const;
+
+private:
+  const Ring *ring;
+  uint64_t wanted;
+  uint64_t missed_frames = 0;
+};
+
+} // namespace telemetry
+
+#endif
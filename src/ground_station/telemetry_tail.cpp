@@ -0,0 +1,92 @@
+// Follows the ground station's live telemetry, see telemetry.hpp. Also a starting point for
+// other readers: attach a Subscriber and call next() whenever convenient.
+//
+//   telemetry_tail [--shm NAME] [--stats]
+//
+// Prints a line per frame, or with --stats a line a second of how many frames arrived and how
+// many this reader missed. Exits once the publisher has stopped and everything is read.
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "telemetry.hpp"
+
+namespace {
+
+const auto IDLE_SLEEP = std::chrono::milliseconds(1);
+
+void print_frame(const telemetry::Frame &frame) {
+  const ActuatorMessage &command = frame.message.actuator_msg;
+  const SensorMessage &sensors = frame.message.sensor_msg;
+  printf("%llu main=%umV actuator=%umV armed=%u contact=%u command=%u%u%u valves=%u%u%u errors=%u\n",
+         static_cast<unsigned long long>(frame.host_time_us), sensors.towerside_main_batt_mv,
+         sensors.towerside_actuator_batt_mv, sensors.towerside_armed, sensors.has_contact, command.ov101,
+         command.ov102, command.ov103, sensors.ov101_state, sensors.ov102_state, sensors.ov103_state,
+         sensors.errors.pending);
+}
+
+int run(int argc, char **argv) {
+  std::string name = telemetry::DEFAULT_NAME;
+  bool stats = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--shm" && i + 1 < argc) {
+      name = argv[++i];
+    } else if (arg == "--stats") {
+      stats = true;
+    } else {
+      std::cerr << "usage: telemetry_tail [--shm NAME] [--stats]\n";
+      return 2;
+    }
+  }
+
+  telemetry::Subscriber subscriber(name);
+  telemetry::Frame frame;
+  uint64_t missed = 0;
+  uint64_t frames = 0;
+  auto last_stats = std::chrono::steady_clock::now();
+  while (true) {
+    // Checked first, so a frame published just before closing is still read
+    bool closed = subscriber.publisher_closed();
+    if (subscriber.next(&frame)) {
+      frames++;
+      if (!stats) {
+        if (subscriber.missed() != missed) {
+          printf("# missed %llu frames\n", static_cast<unsigned long long>(subscriber.missed() - missed));
+          missed = subscriber.missed();
+        }
+        print_frame(frame);
+      }
+    } else if (closed) {
+      break;
+    } else {
+      fflush(stdout);
+      std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (stats && now - last_stats >= std::chrono::seconds(1)) {
+      printf("%llu frames, %llu missed, %llu behind\n", static_cast<unsigned long long>(frames),
+             static_cast<unsigned long long>(subscriber.missed()),
+             static_cast<unsigned long long>(subscriber.backlog()));
+      fflush(stdout);
+      last_stats = now;
+    }
+  }
+  fprintf(stderr, "publisher stopped, %llu frames read, %llu missed\n", static_cast<unsigned long long>(frames),
+          static_cast<unsigned long long>(subscriber.missed()));
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    return run(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << "telemetry_tail: " << e.what() << '\n';
+    return 1;
+  }
+}
@@ -0,0 +1,120 @@
+#include "fields.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+using log_format::RECORD_COMMAND;
+using log_format::RECORD_SENSORS;
+using log_format::RECORD_STATUS;
+
+#define FIELD(prefix, record, message, member)                                                         \
+  Field {                                                                                              \
+    prefix #member, record, offsetof(message, member), sizeof(static_cast<message *>(nullptr)->member) \
+  }
+
+#define ERROR_REPORT_FIELDS(i)                                                                         \
+  FIELD("sensors.", RECORD_SENSORS, SensorMessage, errors.reports[i].device),                          \
+      FIELD("sensors.", RECORD_SENSORS, SensorMessage, errors.reports[i].code),                        \
+      FIELD("sensors.", RECORD_SENSORS, SensorMessage, errors.reports[i].count),                       \
+      FIELD("sensors.", RECORD_SENSORS, SensorMessage, errors.reports[i].active_s)
+
+static_assert(ERROR_REPORTS_PER_MESSAGE == 3, "update the error report fields");
+
+const std::vector<Field> FIELDS = {
+    FIELD("status.", RECORD_STATUS, log_format::StatusRecord, main_batt_mv),
+    FIELD("status.", RECORD_STATUS, log_format::StatusRecord, actuator_batt_mv),
+    FIELD("status.", RECORD_STATUS, log_format::StatusRecord, flags),
+
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, ov101),
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, ov102),
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, ov103),
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, injector_valve),
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, tank_heating_1),
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, tank_heating_2),
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, ignition_primary),
+    FIELD("command.", RECORD_COMMAND, ActuatorMessage, ignition_secondary),
+
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, towerside_main_batt_mv),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, towerside_actuator_batt_mv),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, towerside_main_batt_min_mv),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, towerside_main_batt_max_mv),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, towerside_actuator_batt_min_mv),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, towerside_actuator_batt_max_mv),
+    ERROR_REPORT_FIELDS(0),
+    ERROR_REPORT_FIELDS(1),
+    ERROR_REPORT_FIELDS(2),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, errors.pending),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, towerside_armed),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, has_contact),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, failsafe_latency_ms),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ignition_primary_ma),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ignition_secondary_ma),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov101_state),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov102_state),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov103_state),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov101_open_ms),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov101_close_ms),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov102_open_ms),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov102_close_ms),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov103_open_ms),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, ov103_close_ms),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_temp_dk_1),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_temp_dk_2),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_current_ma_1),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_current_ma_2),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_batt_mv_1),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_batt_mv_2),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_kelvin_low_mv_1),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_kelvin_low_mv_2),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_kelvin_high_mv_1),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_kelvin_high_mv_2),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_duty_1),
+    FIELD("sensors.", RECORD_SENSORS, SensorMessage, heater_duty_2),
+};
+
+#undef ERROR_REPORT_FIELDS
+#undef FIELD
+
+bool matches(const std::string &pattern, const char *name) {
+  if (!pattern.empty() && (pattern.back() == '.' || pattern.back() == '*')) {
+    std::string prefix = pattern.back() == '*' ? pattern.substr(0, pattern.size() - 1) : pattern;
+    return std::string(name).compare(0, prefix.size(), prefix) == 0;
+  }
+  return pattern == name;
+}
+
+} // namespace
+
+const std::vector<Field> &all_fields() {
+  return FIELDS;
+}
+
+std::vector<Field> select_fields(const std::vector<std::string> &names) {
+  std::vector<Field> selected;
+  for (const std::string &name : names) {
+    bool found = false;
+    for (const Field &field : FIELDS) {
+      if (matches(name, field.name)) {
+        selected.push_back(field);
+        found = true;
+      }
+    }
+    if (!found) {
+      throw std::runtime_error("no field matches " + name + ", see the fields command");
+    }
+  }
+  return selected;
+}
+
+bool read_field(const Field &field, const Record &record, uint64_t *value) {
+  if (field.offset + field.size > record.length) {
+    return false;
+  }
+  uint64_t result = 0;
+  for (uint8_t i = 0; i < field.size; i++) {
+    result |= static_cast<uint64_t>(record.payload[field.offset + i]) << (8 * i);
+  }
+  *value = result;
+  return true;
+}
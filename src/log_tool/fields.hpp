@@ -0,0 +1,29 @@
+#ifndef FIELDS_H
+#define FIELDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "log_source.hpp"
+
+// A value inside one type of record. The table is generated from the firmware's own structs
+// with offsetof, so it follows layout changes with a rebuild.
+struct Field {
+  const char *name; // <record>.<member>, e.g. sensors.towerside_main_batt_mv
+  log_format::RecordType record;
+  size_t offset;
+  uint8_t size; // bytes, little endian unsigned
+};
+
+const std::vector<Field> &all_fields();
+
+// Fields matching the names, or every field starting with a name that ends in '.' or '*'.
+// Throws if a name matches nothing.
+std::vector<Field> select_fields(const std::vector<std::string> &names);
+
+// False if the record is too short to hold the field
+bool read_field(const Field &field, const Record &record, uint64_t *value);
+
+#endif
@@ -0,0 +1,126 @@
+#include "index.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char INDEX_MAGIC[4] = {'R', 'I', 'D', 'X'};
+const uint32_t INDEX_VERSION = 2;
+
+struct IndexHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t stride;
+  uint32_t log_version; // log_format::VERSION the index was built with
+  uint64_t log_size;
+  int64_t log_mtime_ns;
+  uint64_t records;
+  uint64_t first_time;
+  uint64_t last_time;
+  uint64_t entries;
+};
+
+} // namespace
+
+Index Index::build(const LogSource &source) {
+  Index index;
+  uint64_t highest = 0;
+  Position latest[RECORD_TYPES];
+  for (Position &type_latest : latest) {
+    type_latest = Position{NO_RECORD, 0};
+  }
+  source.scan(Position{0, 0}, [&](const Record &record, Position position) {
+    if (index.record_count == 0) {
+      index.first = record.time;
+    }
+    highest = std::max(highest, record.time);
+    if (index.record_count % STRIDE == 0) {
+      Entry entry = {highest, position, {}};
+      std::copy(latest, latest + RECORD_TYPES, entry.latest);
+      index.entries.push_back(entry);
+    }
+    if (record.type < RECORD_TYPES) {
+      latest[record.type] = position;
+    }
+    index.record_count++;
+    return true;
+  });
+  index.last = highest;
+  return index;
+}
+
+bool Index::load(const std::string &index_path, const MappedFile &file) {
+  FILE *in = fopen(index_path.c_str(), "rb");
+  if (in == nullptr) {
+    return false;
+  }
+  IndexHeader header;
+  bool ok = fread(&header, sizeof(header), 1, in) == 1 &&
+            memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 &&
+            header.version == INDEX_VERSION && header.stride == STRIDE &&
+            header.log_version == log_format::VERSION && header.log_size == file.size() &&
+            header.log_mtime_ns == file.mtime_ns();
+  if (ok) {
+    entries.resize(header.entries);
+    ok = fread(entries.data(), sizeof(Entry), entries.size(), in) == entries.size();
+    record_count = header.records;
+    first = header.first_time;
+    last = header.last_time;
+  }
+  fclose(in);
+  return ok;
+}
+
+void Index::save(const std::string &index_path, const MappedFile &file) const {
+  FILE *out = fopen(index_path.c_str(), "wb");
+  if (out == nullptr) {
+    return; // read-only directory, the index just gets built again next time
+  }
+  IndexHeader header = {};
+  memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header.version = INDEX_VERSION;
+  header.stride = STRIDE;
+  header.log_version = log_format::VERSION;
+  header.log_size = file.size();
+  header.log_mtime_ns = file.mtime_ns();
+  header.records = record_count;
+  header.first_time = first;
+  header.last_time = last;
+  header.entries = entries.size();
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+            fwrite(entries.data(), sizeof(Entry), entries.size(), out) == entries.size();
+  fclose(out);
+  if (!ok) {
+    remove(index_path.c_str());
+  }
+}
+
+Index Index::load_or_build(const std::string &path, const MappedFile &file, const LogSource &source) {
+  std::string index_path = path + ".idx";
+  Index index;
+  if (index.load(index_path, file)) {
+    return index;
+  }
+  index = build(source);
+  index.save(index_path, file);
+  return index;
+}
+
+Position Index::seek(uint64_t time, std::vector<Position> *earlier) const {
+  earlier->clear();
+  // Everything before the last entry with a lower time is older than time
+  auto after = std::lower_bound(entries.begin(), entries.end(), time,
+                                [](const Entry &entry, uint64_t t) { return entry.time < t; });
+  if (after == entries.begin()) {
+    return Position{0, 0};
+  }
+  const Entry &entry = *(after - 1);
+  for (const Position &position : entry.latest) {
+    if (position.offset != NO_RECORD) {
+      earlier->push_back(position);
+    }
+  }
+  return entry.position;
+}
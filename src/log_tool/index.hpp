@@ -0,0 +1,56 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <string>
+#include <vector>
+
+#include "log_source.hpp"
+
+// Sparse index from time to file position: every STRIDE-th record's time and where to resume
+// scanning for it. Finding a window is a binary search plus at most STRIDE records of scanning
+// before it, so its cost doesn't grow with the file. Each entry also remembers the last record
+// of every type before it, since some (commands, logged only when they change) can be far
+// apart and a window still needs their values from the start.
+//
+// Building it takes one pass over the file. It's saved next to the log as <log>.idx and reused
+// for as long as the log's size and modification time match.
+class Index {
+public:
+  static const uint32_t STRIDE = 256;
+  static const uint8_t RECORD_TYPES = log_format::RECORD_COMMAND + 1;
+  static const uint64_t NO_RECORD = UINT64_MAX; // offset in Entry::latest when there wasn't one
+
+  struct Entry {
+    uint64_t time; // highest time seen up to this record, so the entries stay sorted
+    Position position;
+    Position latest[RECORD_TYPES]; // last record of each type before position, by type
+  };
+
+  static Index load_or_build(const std::string &path, const MappedFile &file, const LogSource &source);
+
+  // Where to scan from to see every record at or after time. earlier gets where the last record
+  // of each type before that is, for the types that have one.
+  Position seek(uint64_t time, std::vector<Position> *earlier) const;
+
+  uint64_t records() const {
+    return record_count;
+  }
+  uint64_t first_time() const {
+    return first;
+  }
+  uint64_t last_time() const {
+    return last;
+  }
+
+private:
+  std::vector<Entry> entries;
+  uint64_t record_count = 0;
+  uint64_t first = 0;
+  uint64_t last = 0;
+
+  static Index build(const LogSource &source);
+  bool load(const std::string &index_path, const MappedFile &file);
+  void save(const std::string &index_path, const MappedFile &file) const;
+};
+
+#endif
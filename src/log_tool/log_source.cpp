@@ -0,0 +1,203 @@
+#include "log_source.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../clientside/config.hpp"
+#include "../ground_station/recording.hpp"
+
+MappedFile::MappedFile(const std::string &path) {
+  fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("can't open " + path + ": " + strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("can't stat " + path + ": " + strerror(errno));
+  }
+  length = st.st_size;
+  if (length == 0) {
+    return; // mmap refuses empty mappings, and there is nothing to read anyway
+  }
+  void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED) {
+    close(fd);
+    throw std::runtime_error("can't map " + path + ": " + strerror(errno));
+  }
+  bytes = static_cast<const uint8_t *>(mapping);
+}
+
+MappedFile::~MappedFile() {
+  if (bytes != nullptr) {
+    munmap(const_cast<uint8_t *>(bytes), length);
+  }
+  close(fd);
+}
+
+int64_t MappedFile::mtime_ns() const {
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return 0;
+  }
+  return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+namespace {
+
+template <typename T> T load(const uint8_t *src) {
+  T value;
+  memcpy(&value, src, sizeof(T));
+  return value;
+}
+
+// towerside's SD card log, see common/log_format.hpp. Blocks with a bad header are skipped.
+class TowersideLog : public LogSource {
+  const MappedFile &file;
+
+public:
+  explicit TowersideLog(const MappedFile &file) : file{file} {}
+
+  const char *format() const override {
+    return "towerside log";
+  }
+  const char *time_unit() const override {
+    return "ms";
+  }
+
+  void scan(Position from, const std::function<bool(const Record &, Position)> &visit) const override {
+    const uint64_t first_block = from.offset / log_format::BLOCK_SIZE;
+    for (uint64_t block = first_block; (block + 1) * log_format::BLOCK_SIZE <= file.size(); block++) {
+      const uint8_t *start = file.data() + block * log_format::BLOCK_SIZE;
+      log_format::BlockHeader header = load<log_format::BlockHeader>(start);
+      if (header.magic != log_format::BLOCK_MAGIC || header.version != log_format::VERSION ||
+          header.used > log_format::BLOCK_DATA_SIZE) {
+        continue;
+      }
+      uint64_t offset = sizeof(header);
+      // Records before the starting one are only skipped in the first block
+      uint64_t resume = block == first_block ? from.offset % log_format::BLOCK_SIZE : 0;
+      const uint64_t end = sizeof(header) + header.used;
+      while (offset + sizeof(log_format::RecordHeader) <= end) {
+        log_format::RecordHeader record = load<log_format::RecordHeader>(start + offset);
+        uint64_t next = offset + sizeof(record) + record.length;
+        if (next > end) {
+          break;
+        }
+        if (offset >= resume) {
+          Position position = {block * log_format::BLOCK_SIZE + offset, 0};
+          if (!visit(Record{record.time_ms, record.type, start + offset + sizeof(record), record.length},
+                     position)) {
+            return;
+          }
+        }
+        offset = next;
+      }
+    }
+  }
+};
+
+// A raw capture of clientside's USB output: config::USBMessage frames of 'W' <message> 'R' '\n'.
+// There are no timestamps in it, so time is the frame number. Bytes that don't line up with a
+// frame are skipped a byte at a time until one does, the same as the Communicator would.
+class UsbCapture : public LogSource {
+  static const size_t FRAME_SIZE = sizeof(config::USBMessage) + 3;
+
+  const MappedFile &file;
+
+  bool is_frame(uint64_t offset) const {
+    const uint8_t *data = file.data();
+    return offset + FRAME_SIZE <= file.size() && data[offset] == 'W' &&
+           data[offset + FRAME_SIZE - 2] == 'R' && data[offset + FRAME_SIZE - 1] == '\n';
+  }
+
+public:
+  explicit UsbCapture(const MappedFile &file) : file{file} {}
+
+  const char *format() const override {
+    return "clientside USB capture";
+  }
+  const char *time_unit() const override {
+    return "frame";
+  }
+
+  void scan(Position from, const std::function<bool(const Record &, Position)> &visit) const override {
+    const uint8_t *data = file.data();
+    uint64_t frame = from.frame;
+    for (uint64_t offset = from.offset; offset + FRAME_SIZE <= file.size();) {
+      if (!is_frame(offset)) {
+        offset++;
+        continue;
+      }
+      // Each frame becomes a command record and a sensors record, so both share a field table
+      // with the towerside log
+      const uint8_t *msg = data + offset + 1;
+      Position position = {offset, frame};
+      if (!visit(Record{frame, log_format::RECORD_COMMAND, msg + offsetof(config::USBMessage, actuator_msg),
+                        sizeof(ActuatorMessage)},
+                 position) ||
+          !visit(Record{frame, log_format::RECORD_SENSORS, msg + offsetof(config::USBMessage, sensor_msg),
+                        sizeof(SensorMessage)},
+                 position)) {
+        return;
+      }
+      offset += FRAME_SIZE;
+      frame++;
+    }
+  }
+};
+
+// The ground station recorder's output, see ground_station/recording.hpp. The same records as a
+// USB capture, but timed by the host clock in microseconds.
+class GroundStationRecording : public LogSource {
+  const MappedFile &file;
+
+public:
+  explicit GroundStationRecording(const MappedFile &file) : file{file} {
+    recording::FileHeader header = load<recording::FileHeader>(file.data());
+    if (header.version != recording::VERSION || header.entry_size != sizeof(recording::Entry)) {
+      throw std::runtime_error("recording is from a different message layout than this build");
+    }
+  }
+
+  const char *format() const override {
+    return "ground station recording";
+  }
+  const char *time_unit() const override {
+    return "us";
+  }
+
+  void scan(Position from, const std::function<bool(const Record &, Position)> &visit) const override {
+    uint64_t offset = from.offset < sizeof(recording::FileHeader) ? sizeof(recording::FileHeader) : from.offset;
+    for (; offset + sizeof(recording::Entry) <= file.size(); offset += sizeof(recording::Entry)) {
+      const uint8_t *entry = file.data() + offset;
+      uint64_t time = load<uint64_t>(entry + offsetof(recording::Entry, host_time_us));
+      const uint8_t *msg = entry + offsetof(recording::Entry, message);
+      Position position = {offset, 0};
+      if (!visit(Record{time, log_format::RECORD_COMMAND, msg + offsetof(config::USBMessage, actuator_msg),
+                        sizeof(ActuatorMessage)},
+                 position) ||
+          !visit(Record{time, log_format::RECORD_SENSORS, msg + offsetof(config::USBMessage, sensor_msg),
+                        sizeof(SensorMessage)},
+                 position)) {
+        return;
+      }
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<LogSource> open_source(const MappedFile &file) {
+  if (file.size() >= sizeof(uint32_t) && load<uint32_t>(file.data()) == log_format::BLOCK_MAGIC) {
+    return std::unique_ptr<LogSource>(new TowersideLog(file));
+  }
+  if (file.size() >= sizeof(recording::FileHeader) && load<uint32_t>(file.data()) == recording::MAGIC) {
+    return std::unique_ptr<LogSource>(new GroundStationRecording(file));
+  }
+  return std::unique_ptr<LogSource>(new UsbCapture(file));
+}
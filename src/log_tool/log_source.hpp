@@ -0,0 +1,63 @@
+#ifndef LOG_SOURCE_H
+#define LOG_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "common/log_format.hpp"
+
+// A read-only memory mapping of a whole file. Pages are only read from disk as they're touched,
+// so decoding a window of a large capture costs about the size of the window.
+class MappedFile {
+  int fd = -1;
+  const uint8_t *bytes = nullptr;
+  size_t length = 0;
+
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const uint8_t *data() const {
+    return bytes;
+  }
+  size_t size() const {
+    return length;
+  }
+  // Modification time, to tell whether a saved index still belongs to the file
+  int64_t mtime_ns() const;
+};
+
+// One decoded record, pointing into the mapped file
+struct Record {
+  uint64_t time; // in the source's time unit
+  log_format::RecordType type;
+  const uint8_t *payload;
+  uint8_t length;
+};
+
+// Where scan() was when it produced a record, scanning again from here picks up at that record
+struct Position {
+  uint64_t offset; // in the file
+  uint64_t frame; // frames before this one, for sources that count time in frames
+};
+
+class LogSource {
+public:
+  virtual ~LogSource() {}
+
+  virtual const char *format() const = 0;
+  virtual const char *time_unit() const = 0;
+
+  // Calls visit with every record from position on, in file order, until it returns false
+  virtual void scan(Position from, const std::function<bool(const Record &, Position)> &visit) const = 0;
+};
+
+// Picks the decoder by looking at the start of the file
+std::unique_ptr<LogSource> open_source(const MappedFile &file);
+
+#endif
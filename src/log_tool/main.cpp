@@ -0,0 +1,244 @@
+// Pulls channels out of towerside SD card logs, ground station recordings and raw captures of
+// clientside's USB output.
+//
+//   log_tool fields                                  list the field names
+//   log_tool info <log>                              format, record count and time range
+//   log_tool csv <log> [window] <field>...           CSV on stdout
+//   log_tool columns <log> <dir> [window] <field>... one little endian binary file per column
+//
+// window is --from <time> and/or --to <time>, inclusive, in the log's time unit (ms for
+// towerside logs, unix time in us for ground station recordings, frames for USB captures).
+// A field name ending in '.' or '*' selects every field starting with it, e.g.
+// "sensors.heater_*" or "command.".
+//
+// Each output row is a record that holds at least one of the selected fields. Fields from
+// other record types hold their last value, and are empty (CSV) or NaN (columns) until the
+// first record with them. A window with --from starts with a row at that time holding the
+// values in force then, including ones last logged long before.
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "fields.hpp"
+#include "index.hpp"
+#include "log_source.hpp"
+
+namespace {
+
+struct Window {
+  uint64_t from = 0;
+  uint64_t to = UINT64_MAX;
+};
+
+// Values of the selected fields as of the current record
+struct Row {
+  uint64_t time;
+  std::vector<uint64_t> values;
+  std::vector<bool> known;
+};
+
+template <typename OnRow>
+void extract(const LogSource &source, const Index &index, const Window &window, const std::vector<Field> &fields,
+             OnRow on_row) {
+  Row row = {0, std::vector<uint64_t>(fields.size()), std::vector<bool>(fields.size())};
+  auto update = [&](const Record &record) {
+    bool updated = false;
+    for (size_t i = 0; i < fields.size(); i++) {
+      if (fields[i].record == record.type && read_field(fields[i], record, &row.values[i])) {
+        row.known[i] = true;
+        updated = true;
+      }
+    }
+    return updated;
+  };
+  std::vector<Position> earlier;
+  Position start = index.seek(window.from, &earlier);
+  // Records logged only on change may be long before the scan starts, pick up their values first
+  for (const Position &position : earlier) {
+    source.scan(position, [&](const Record &record, Position) {
+      update(record);
+      return false;
+    });
+  }
+  // A window starting partway through opens with a row of the values in force at its start, so
+  // fields that don't change inside it still show up
+  bool opened = window.from == 0;
+  auto any_known = [&]() { return std::find(row.known.begin(), row.known.end(), true) != row.known.end(); };
+  source.scan(start, [&](const Record &record, Position) {
+    bool opening = !opened && record.time >= window.from;
+    if (opening) {
+      opened = true;
+      if (record.time > window.from && any_known()) {
+        row.time = window.from;
+        on_row(row);
+      }
+    }
+    if (record.time > window.to) {
+      return false;
+    }
+    bool updated = update(record);
+    if (record.time >= window.from && (updated || (opening && record.time == window.from && any_known()))) {
+      row.time = record.time;
+      on_row(row);
+    }
+    return true;
+  });
+}
+
+void write_csv(const LogSource &source, const Index &index, const Window &window,
+               const std::vector<Field> &fields) {
+  std::string line = std::string("time_") + source.time_unit();
+  for (const Field &field : fields) {
+    line += ',';
+    line += field.name;
+  }
+  line += '\n';
+  fputs(line.c_str(), stdout);
+  extract(source, index, window, fields, [&](const Row &row) {
+    line = std::to_string(row.time);
+    for (size_t i = 0; i < fields.size(); i++) {
+      line += ',';
+      if (row.known[i]) {
+        line += std::to_string(row.values[i]);
+      }
+    }
+    line += '\n';
+    fputs(line.c_str(), stdout);
+  });
+}
+
+class Column {
+  FILE *file;
+  std::string path;
+
+public:
+  Column(const std::string &path) : file{fopen(path.c_str(), "wb")}, path{path} {
+    if (file == nullptr) {
+      throw std::runtime_error("can't create " + path + ": " + strerror(errno));
+    }
+  }
+  ~Column() {
+    fclose(file);
+  }
+  template <typename T> void append(T value) {
+    if (fwrite(&value, sizeof(value), 1, file) != 1) {
+      throw std::runtime_error("can't write " + path + ": " + strerror(errno));
+    }
+  }
+};
+
+// time.u64 holds the times, and <field>.f64 each field as a double so NaN can mark it unknown.
+// numpy.fromfile(path, dtype="<u8") or "<f8" reads them.
+void write_columns(const LogSource &source, const Index &index, const Window &window,
+                   const std::vector<Field> &fields, const std::string &dir) {
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    throw std::runtime_error("can't create " + dir + ": " + strerror(errno));
+  }
+  Column time(dir + "/time.u64");
+  std::vector<std::unique_ptr<Column>> columns;
+  for (const Field &field : fields) {
+    columns.emplace_back(new Column(dir + "/" + field.name + ".f64"));
+  }
+  uint64_t rows = 0;
+  extract(source, index, window, fields, [&](const Row &row) {
+    time.append<uint64_t>(row.time);
+    for (size_t i = 0; i < fields.size(); i++) {
+      columns[i]->append<double>(row.known[i] ? static_cast<double>(row.values[i]) : NAN);
+    }
+    rows++;
+  });
+  std::cerr << rows << " rows written to " << dir << '\n';
+}
+
+uint64_t parse_time(const std::string &text) {
+  size_t end;
+  unsigned long long value = std::stoull(text, &end);
+  if (end != text.size()) {
+    throw std::invalid_argument("not a time: " + text);
+  }
+  return value;
+}
+
+// Splits the window options out of args
+Window parse_window(std::vector<std::string> *args) {
+  Window window;
+  std::vector<std::string> rest;
+  for (size_t i = 0; i < args->size(); i++) {
+    const std::string &arg = (*args)[i];
+    if ((arg == "--from" || arg == "--to") && i + 1 < args->size()) {
+      (arg == "--from" ? window.from : window.to) = parse_time((*args)[++i]);
+    } else {
+      rest.push_back(arg);
+    }
+  }
+  *args = rest;
+  return window;
+}
+
+void usage() {
+  std::cerr << "usage: log_tool fields\n"
+               "       log_tool info <log>\n"
+               "       log_tool csv <log> [--from T] [--to T] <field>...\n"
+               "       log_tool columns <log> <dir> [--from T] [--to T] <field>...\n";
+}
+
+int run(std::vector<std::string> args) {
+  if (args.empty()) {
+    usage();
+    return 2;
+  }
+  std::string command = args[0];
+  args.erase(args.begin());
+
+  if (command == "fields") {
+    const char *record_names[] = {"", "status", "sensors", "command"};
+    for (const Field &field : all_fields()) {
+      std::cout << field.name << " (" << record_names[field.record] << " record, " << static_cast<int>(field.size)
+                << " bytes)\n";
+    }
+    return 0;
+  }
+
+  Window window = parse_window(&args);
+  size_t needed = command == "info" ? 1 : command == "csv" ? 2 : command == "columns" ? 3 : 0;
+  if (needed == 0 || args.size() < needed) {
+    usage();
+    return 2;
+  }
+
+  MappedFile file(args[0]);
+  std::unique_ptr<LogSource> source = open_source(file);
+  Index index = Index::load_or_build(args[0], file, *source);
+
+  if (command == "info") {
+    std::cout << args[0] << ": " << source->format() << ", " << file.size() << " bytes\n"
+              << index.records() << " records from " << index.first_time() << " to " << index.last_time() << ' '
+              << source->time_unit() << '\n';
+    return 0;
+  }
+  if (command == "csv") {
+    write_csv(*source, index, window, select_fields(std::vector<std::string>(args.begin() + 1, args.end())));
+    return 0;
+  }
+  write_columns(*source, index, window, select_fields(std::vector<std::string>(args.begin() + 2, args.end())),
+                args[1]);
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  try {
+    return run(std::vector<std::string>(argv + 1, argv + argc));
+  } catch (const std::exception &e) {
+    std::cerr << "log_tool: " << e.what() << '\n';
+    return 1;
+  }
+}
@@ -0,0 +1,109 @@
+#include "i2c_regs.h"
+
+// Reads are served from one of two snapshot buffers. The main loop fills the one that isn't
+// published and then publishes it, and a read latches the published one when it is addressed.
+// That keeps every read coherent, and leaves the interrupt only indexing into a buffer.
+static uint8_t snapshots[2][I2C_REGS_MAX_SIZE];
+static uint8_t snapshot_size = 0;
+static volatile uint8_t published = 0; // buffer holding the newest complete snapshot
+static volatile uint8_t latched = 0; // buffer the current read is served from
+static volatile bool reading = false; // whether a read is still using the latched buffer
+static uint8_t write_buffer[I2C_REGS_MAX_REG_SIZE]; // bytes of the register being written
+
+static uint8_t reg_address = 0; // address from the most recent write, reads start here
+static uint8_t pointer = 0; // address of the next byte in the current transaction
+static bool expecting_address = false;
+
+void i2c_regs_publish(void) {
+    uint8_t target = published ^ 1;
+    // Never overwrite a buffer that a read is being served from. The interrupt only ever
+    // latches the published buffer, so once this check passes the target stays ours.
+    if (reading && latched == target) {
+        return;
+    }
+
+    uint8_t *snapshot = snapshots[target];
+    uint8_t start = 0;
+    for (uint8_t i = 0; i < i2c_num_registers; i++) {
+        const i2c_reg_t *reg = &i2c_registers[i];
+        if (start + reg->size > I2C_REGS_MAX_SIZE) {
+            break; // I2C_REGS_MAX_SIZE is too small for this board, the rest reads as 0
+        }
+        if (reg->read != NULL) {
+            reg->read(&snapshot[start]);
+        } else {
+            for (uint8_t j = 0; j < reg->size; j++) {
+                snapshot[start + j] = 0;
+            }
+        }
+        start += reg->size;
+    }
+    snapshot_size = start;
+    published = target;
+}
+
+void i2c_regs_start_write(void) {
+    reading = false;
+    expecting_address = true;
+}
+
+void i2c_regs_write_byte(uint8_t data) {
+    if (expecting_address) {
+        expecting_address = false;
+        reg_address = data;
+        pointer = data;
+        return;
+    }
+
+    // Find the register this byte belongs to
+    uint8_t start = 0;
+    for (uint8_t i = 0; i < i2c_num_registers; i++) {
+        const i2c_reg_t *reg = &i2c_registers[i];
+        if (pointer < start + reg->size) {
+            uint8_t offset = pointer - start;
+            if (offset < I2C_REGS_MAX_REG_SIZE) {
+                write_buffer[offset] = data;
+            }
+            // Only commit once the last byte arrives, so multi-byte values land together
+            if (offset == reg->size - 1 && reg->write != NULL) {
+                reg->write(write_buffer);
+            }
+            break;
+        }
+        start += reg->size;
+    }
+
+    if (pointer < 0xFF) {
+        pointer++;
+    }
+}
+
+void i2c_regs_start_read(void) {
+    latched = published;
+    reading = true;
+    pointer = reg_address;
+}
+
+uint8_t i2c_regs_read_byte(void) {
+    uint8_t data = 0;
+    if (pointer < snapshot_size) {
+        data = snapshots[latched][pointer];
+    }
+    if (pointer < 0xFF) {
+        pointer++;
+    }
+    return data;
+}
+
+void i2c_regs_stop(void) {
+    reading = false;
+}
+
+void i2c_regs_put_u16(uint8_t *dest, uint16_t value) {
+    dest[0] = (uint8_t)(value & 0xFF);
+    dest[1] = (uint8_t)(value >> 8);
+}
+
+uint16_t i2c_regs_get_u16(const uint8_t *src) {
+    return ((uint16_t)src[1] << 8) | src[0];
+}
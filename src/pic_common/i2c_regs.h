@@ -0,0 +1,64 @@
+#ifndef I2C_REGS_H
+#define I2C_REGS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Byte-addressable register file shared by the I2C slave firmware on every PIC board.
+ * Each board declares its registers in i2c_registers[], the hardware driver feeds bus
+ * events into the i2c_regs_* functions below, and this module does the rest.
+ *
+ * Protocol:
+ *  - The first byte of a write is the register address. Any further bytes are written
+ *    starting at that address, auto-incrementing. Write whole registers at a time.
+ *  - Reads start at the address from the most recent write and auto-increment, so one
+ *    read can burst through consecutive registers. Reading past the end returns 0.
+ *  - Reads are served from a snapshot of every register that the main loop publishes
+ *    with i2c_regs_publish(). A read latches the newest snapshot when it is addressed,
+ *    so multi-byte registers and bursts are coherent for the whole transaction.
+ *  - Multi-byte values are little endian.
+ */
+
+// Size of the whole register file, in bytes. Can be overridden from the project's macros.
+#ifndef I2C_REGS_MAX_SIZE
+#define I2C_REGS_MAX_SIZE 16
+#endif
+
+// Size of the largest writable register, in bytes
+#ifndef I2C_REGS_MAX_REG_SIZE
+#define I2C_REGS_MAX_REG_SIZE 2
+#endif
+
+typedef struct {
+    // Width of the register in bytes
+    uint8_t size;
+    // Fills dest with the register's current value, called from i2c_regs_publish().
+    // NULL reads as 0.
+    void (*read)(uint8_t *dest);
+    // Called from the I2C interrupt once every byte of the register has been written.
+    // NULL makes the register read-only.
+    void (*write)(const uint8_t *src);
+} i2c_reg_t;
+
+// Provided by each board: its registers in address order, starting at address 0
+extern const i2c_reg_t i2c_registers[];
+extern const uint8_t i2c_num_registers;
+
+// Takes a fresh snapshot of every register for reads to be served from. Call this from the
+// main loop whenever the values behind the registers have been updated.
+void i2c_regs_publish(void);
+
+// Bus events, called by the hardware driver from the I2C interrupt
+void i2c_regs_start_write(void);
+void i2c_regs_write_byte(uint8_t data);
+void i2c_regs_start_read(void);
+uint8_t i2c_regs_read_byte(void);
+void i2c_regs_stop(void);
+
+// Helpers for register hooks
+void i2c_regs_put_u16(uint8_t *dest, uint16_t value);
+uint16_t i2c_regs_get_u16(const uint8_t *src);
+
+#endif /* I2C_REGS_H */
@@ -0,0 +1,125 @@
+#include <xc.h>
+
+#include "i2c_regs.h"
+#include "i2c_slave.h"
+
+// Where we are in the current transaction. Every interrupt handles exactly one byte (or the
+// stop condition) and returns, so the clock is never held low waiting for the next byte.
+typedef enum {
+    I2C_STATE_IDLE,
+    I2C_STATE_WRITE, // master is sending us data bytes
+    I2C_STATE_READ, // master is reading data bytes from us
+} i2c_state_t;
+
+static i2c_state_t state = I2C_STATE_IDLE;
+
+// Timing of the interrupt, in microseconds (Timer2 ticks). Timer2 wraps every 256us, so longer
+// durations wrap around too, see elapsed_us().
+static uint8_t isr_last_us = 0;
+static uint8_t isr_max_us = 0;
+static uint8_t stretch_last_us = 0;
+static uint8_t stretch_max_us = 0;
+
+void i2c_slave_init(uint16_t address) {
+    SSPSTAT = 0x80;
+    SSPADDbits.SSPADD = address << 1; // 7 bit addressing, LSB is unused
+    SSPCON = 0x36;
+    SSPCON2 = 0x01;
+    TRISB1 = 1; // SDA
+    TRISB4 = 1; // SCL
+    GIE = 1;
+    PEIE = 1;
+    SSP1CON3bits.PCIE = 1; // Interrupt on stop, so we know when a read has finished
+    SSP1IF = 0;
+    SSP1IE = 1;
+    state = I2C_STATE_IDLE;
+
+    // Timer2 free runs from the instruction clock (1 MHz) and is only used as a stopwatch
+    // for the interrupt timing below
+    PR2 = 0xFF;
+    T2CONbits.T2CKPS = 0b00; // 1:1 prescaler
+    T2CONbits.T2OUTPS = 0b0000; // 1:1 postscaler
+    T2CONbits.TMR2ON = 1;
+}
+
+void i2c_slave_read_timing(uint8_t *dest) {
+    dest[0] = isr_last_us;
+    dest[1] = isr_max_us;
+    dest[2] = stretch_last_us;
+    dest[3] = stretch_max_us;
+}
+
+static uint8_t elapsed_us(uint8_t start) {
+    uint8_t now = TMR2;
+    // Wraps for durations longer than a Timer2 period, the interrupt itself takes far less
+    return now - start;
+}
+
+void i2c_slave_mask(void) {
+    SSP1IE = 0;
+}
+
+void i2c_slave_unmask(void) {
+    SSP1IE = 1;
+}
+
+void i2c_handle_interrupt(void) {
+    uint8_t start = TMR2;
+    uint8_t temp;
+
+    SSP1IF = 0;
+
+    // If overflow or collision, drop the transaction
+    if ((SSPCONbits.SSPOV) || (SSPCONbits.WCOL)) {
+        temp = SSPBUF; // Read the previous value to clear the buffer
+        SSPCONbits.SSPOV = 0; // Clear the overflow flag
+        SSPCONbits.WCOL = 0; // Clear the collision bit
+        state = I2C_STATE_IDLE;
+    }
+    // If the transaction is over
+    else if (SSPSTATbits.P) {
+        i2c_regs_stop();
+        state = I2C_STATE_IDLE;
+    }
+    // If this is our address, a new transaction is starting
+    else if (!SSPSTATbits.D_nA) {
+        temp = SSPBUF; // Address byte, read it to clear BF
+        if (SSPSTATbits.R_nW) {
+            state = I2C_STATE_READ;
+            i2c_regs_start_read(); // Latch the published snapshot for the whole transaction
+            SSPBUF = i2c_regs_read_byte();
+        } else {
+            state = I2C_STATE_WRITE;
+            i2c_regs_start_write();
+        }
+    }
+    // If this is a data byte of a write
+    else if (state == I2C_STATE_WRITE) {
+        if (SSPSTATbits.BF) {
+            i2c_regs_write_byte(SSPBUF);
+        }
+    }
+    // If the master clocked out a byte we sent
+    else if (state == I2C_STATE_READ) {
+        if (!SSPCON2bits.ACKSTAT) {
+            SSPBUF = i2c_regs_read_byte(); // ACK, the master wants another byte
+        } else {
+            state = I2C_STATE_IDLE; // NACK, the master is done reading
+        }
+    }
+
+    // Release the clock
+    SSPCONbits.CKP = 1;
+
+    // Approximate: the clock was already held from the byte completing until this interrupt
+    // started, which isn't counted. That's the interrupt latency plus however long other
+    // interrupts or a masked section kept it waiting.
+    stretch_last_us = elapsed_us(start);
+    if (stretch_last_us > stretch_max_us) {
+        stretch_max_us = stretch_last_us;
+    }
+    isr_last_us = elapsed_us(start);
+    if (isr_last_us > isr_max_us) {
+        isr_max_us = isr_last_us;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef I2C_SLAVE_H
+#define I2C_SLAVE_H
+
+#include <stdint.h>
+
+// I2C slave driver for the MSSP module on the PIC16F1826 boards. Bus traffic is
+// handed to the register file in i2c_regs.h.
+
+// Initializes i2c module
+void i2c_slave_init(uint16_t address);
+
+// interrupt handling of i2c signal
+void i2c_handle_interrupt(void);
+
+// Register read hook (4 bytes) reporting how long the interrupt takes, in microseconds:
+// last and max interrupt duration, then last and max time from the interrupt starting to it
+// releasing the clock (approximate, it misses the wait before the interrupt runs, see
+// i2c_slave.c). Durations wrap at 256us.
+void i2c_slave_read_timing(uint8_t *dest);
+
+// Masks the I2C interrupt from the main loop, e.g. to read settings it writes. Keep the masked
+// section short, a byte that completes meanwhile stretches the bus clock until it ends.
+void i2c_slave_mask(void);
+void i2c_slave_unmask(void);
+
+#endif /* I2C_SLAVE_H */
@@ -37,12 +37,16 @@ void loop()
       digitalWrite(LED_BUILTIN, LOW); // sets the digital pin 13 off
     }
     Wire.beginTransmission(3); // transmit to device #2
+    Wire.write(5);             // control register
     Wire.write(x);             // sends one bytes
     Wire.endTransmission();    // stop transmitting
   }
   delay(50);
   
-  Wire.requestFrom(3, 5);
+  Wire.beginTransmission(3);
+  Wire.write(0);             // read from the status register onwards
+  Wire.endTransmission();
+  Wire.requestFrom(3, 10);
   Serial.print("lims: ");
   uint8_t lims = Wire.read();
   Serial.println(lims);
@@ -52,5 +56,25 @@ void loop()
     uint16_t current = (((uint16_t)adch << 8) | adcl) * 2;
     Serial.println(current);         // print the byte
   }
+  Wire.read();                     // control register, ignore
+  Serial.print("i2c isr us (last/max), clock stretch us (last/max): ");
+  for (int i = 0; i < 4; i++) {
+    Serial.print(Wire.read());
+    Serial.print(" ");
+  }
+  Serial.println();
+
+  Wire.beginTransmission(3);
+  Wire.write(0x1E);          // stroke times and transition age
+  Wire.endTransmission();
+  Wire.requestFrom(3, 6);
+  Serial.print("stroke open/close ms, transition age ms: ");
+  for (int i = 0; i < 3; i++) {
+    uint8_t low = Wire.read();
+    uint8_t high = Wire.read();
+    Serial.print(((uint16_t)high << 8) | low);
+    Serial.print(" ");
+  }
+  Serial.println();
   delay(50);
 }
@@ -1,88 +1,130 @@
 #include "i2c.h"
 #include "relay_general.h"
+#include "stroke.h"
+#include "waveform.h"
 
-uint16_t i2cSlaveRecv; // Data received on i2c
-uint16_t i2cSlaveSend; // Data to be sent on i2c
-
-void i2c_slave_init(uint16_t address) {
-    SSPSTAT = 0x80;
-    SSPADDbits.SSPADD = address << 1; //7 bit addressing, LSB is unused
-    SSPCON = 0x36;
-    SSPCON2 = 0x01;
-    TRISB1 = 1; // SDA
-    TRISB4 = 1; // SCL
-    GIE = 1;
-    PEIE = 1;
-    SSP1IF = 0;
-    SSP1IE = 1;
-}
-
-#define TIMEOUT 200
-void i2c_handle_interrupt(void) {
-    uint16_t temp;
-    uint16_t timeout = 0;
-    SSPCONbits.CKP = 0;
-
-    SSP1IF = 0;
-
-    // If overflow or collision.
-    if ((SSPCONbits.SSPOV) || (SSPCONbits.WCOL)) {
-        temp = SSPBUF; // Read the previous value to clear the buffer
-        SSPCONbits.SSPOV = 0; // Clear the overflow flag
-        SSPCONbits.WCOL = 0;   // Clear the collision bit
-        SSPCONbits.CKP = 1;
-        return;
-    }
+static uint8_t wave_index = 0;
+
+static void read_status(uint8_t *dest) {
+    dest[0] = (get_overcurrent_faults() << 2) | (get_lim2() << 1) | get_lim1();
+}
+
+static void read_curr_sense_1(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_inputs(CURR_SENSE_1));
+}
+
+static void read_curr_sense_2(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_inputs(CURR_SENSE_2));
+}
+
+static void read_adc_samples(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_sample_count(CURR_SENSE_1));
+    i2c_regs_put_u16(dest + 2, get_analog_sample_count(CURR_SENSE_2));
+}
+
+static void read_control(uint8_t *dest) {
+    dest[0] = (get_select() << 1) | get_power();
+}
 
-    // If last byte was Address + write
-    if (!SSPSTATbits.D_nA && !SSPSTATbits.R_nW) {
-        while(!BF && timeout < TIMEOUT) timeout++;
-        temp = SSP1BUF;
-        BF = 0;
-        SSPCONbits.CKP = 1;
-        while(!BF && timeout < TIMEOUT) timeout++;
-        i2cSlaveRecv = SSP1BUF;
-        if (timeout < TIMEOUT) {
-            // LSB is power, second bit is select
-            if (i2cSlaveRecv & (1 << 1)) {
-                set_select_on();
-            } else {
-                set_select_off();
-            }
-            if (i2cSlaveRecv & 1) {
-                set_power_on();
-            } else {
-                set_power_off();
-            }
-        }
-        SSPCONbits.CKP = 1;
-        BF = 0;
-        // We already set this above but for some reason we need to set it here too
-        SSP1IF = 0;
+static void write_control(const uint8_t *src) {
+    // LSB is power, second bit is select, third bit clears latched trips first
+    if (src[0] & (1 << 2)) {
+        clear_overcurrent_faults();
     }
-    // If this is a read
-    else if (SSPSTATbits.R_nW) {
-        static uint8_t read_pointer;
-        // If this is the first byte in a read
-        if (!SSPSTATbits.D_nA) {
-            read_pointer = 0;
-        }
-        temp = SSPBUF;
-        
-        if (read_pointer == 0) {
-            SSPBUF = (get_lim2() << 1) | get_lim1();
-        } else if (read_pointer == 1) {
-            SSPBUF = (uint8_t)(get_analog_inputs(CURR_SENSE_1) & 0xFF);
-        } else if (read_pointer == 2) {
-            SSPBUF = (uint8_t)(get_analog_inputs(CURR_SENSE_1) >> 8);
-        } else if (read_pointer == 3) {
-            SSPBUF = (uint8_t)(get_analog_inputs(CURR_SENSE_2) & 0xFF);
-        } else if (read_pointer == 4) {
-            SSPBUF = (uint8_t)(get_analog_inputs(CURR_SENSE_2) >> 8);
-        }
-        
-        read_pointer++;
-        SSPCONbits.CKP = 1;
+    if (src[0] & (1 << 1)) {
+        set_select_on();
+    } else {
+        set_select_off();
+    }
+    if ((src[0] & 1) && !get_overcurrent_faults()) {
+        set_power_on();
+    } else {
+        set_power_off();
+    }
+}
+
+static void read_trip_threshold(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_trip_threshold());
+}
+
+static void write_trip_threshold(const uint8_t *src) {
+    set_trip_threshold(i2c_regs_get_u16(src));
+}
+
+static void read_trip_samples(uint8_t *dest) {
+    dest[0] = get_trip_samples();
+}
+
+static void write_trip_samples(const uint8_t *src) {
+    set_trip_samples(src[0]);
+}
+
+static void read_wave_control(uint8_t *dest) {
+    dest[0] = (waveform_channel() << 1) | waveform_done();
+}
+
+static void write_wave_control(const uint8_t *src) {
+    if (src[0] & 1) {
+        waveform_arm((src[0] >> 1) & 1);
     }
-    SSPCONbits.CKP = 1;
 }
+
+static void read_wave_length(uint8_t *dest) {
+    dest[0] = waveform_length();
+}
+
+static void read_wave_decimation(uint8_t *dest) {
+    dest[0] = waveform_decimation();
+}
+
+static void write_wave_decimation(const uint8_t *src) {
+    waveform_set_decimation(src[0]);
+}
+
+static void read_wave_index(uint8_t *dest) {
+    dest[0] = wave_index;
+}
+
+static void write_wave_index(const uint8_t *src) {
+    wave_index = src[0];
+}
+
+static void read_wave_data(uint8_t *dest) {
+    // Echo the index so the reader can tell a chunk apart from a snapshot taken before its
+    // index write landed
+    uint8_t index = wave_index;
+    dest[0] = waveform_read(index, dest + 1) ? index : 0xFF;
+}
+
+static void read_stroke_open(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_stroke_open_ms());
+}
+
+static void read_stroke_close(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_stroke_close_ms());
+}
+
+static void read_transition_age(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_last_transition_age_ms());
+}
+
+// Must stay in the order of the addresses in i2c.h
+const i2c_reg_t i2c_registers[] = {
+    {1, read_status, NULL}, // RELAY_REG_STATUS
+    {2, read_curr_sense_1, NULL}, // RELAY_REG_CURR_SENSE_1
+    {2, read_curr_sense_2, NULL}, // RELAY_REG_CURR_SENSE_2
+    {1, read_control, write_control}, // RELAY_REG_CONTROL
+    {4, i2c_slave_read_timing, NULL}, // RELAY_REG_I2C_TIMING
+    {4, read_adc_samples, NULL}, // RELAY_REG_ADC_SAMPLES
+    {2, read_trip_threshold, write_trip_threshold}, // RELAY_REG_TRIP_THRESHOLD
+    {1, read_trip_samples, write_trip_samples}, // RELAY_REG_TRIP_SAMPLES
+    {1, read_wave_control, write_wave_control}, // RELAY_REG_WAVE_CONTROL
+    {1, read_wave_length, NULL}, // RELAY_REG_WAVE_LENGTH
+    {1, read_wave_decimation, write_wave_decimation}, // RELAY_REG_WAVE_DECIMATION
+    {1, read_wave_index, write_wave_index}, // RELAY_REG_WAVE_INDEX
+    {1 + WAVE_CHUNK_SIZE, read_wave_data, NULL}, // RELAY_REG_WAVE_DATA
+    {2, read_stroke_open, NULL}, // RELAY_REG_STROKE_OPEN
+    {2, read_stroke_close, NULL}, // RELAY_REG_STROKE_CLOSE
+    {2, read_transition_age, NULL}, // RELAY_REG_TRANSITION_AGE
+};
+const uint8_t i2c_num_registers = sizeof(i2c_registers) / sizeof(i2c_registers[0]);
@@ -8,11 +8,37 @@
 #include <xc.h>
 #include <pic16f1826.h>
 
-//Initializes i2c module
-void i2c_slave_init(uint16_t address);
+#include "../pic_common/i2c_regs.h"
+#include "../pic_common/i2c_slave.h"
 
-//interrupt handling of i2c signal
-void i2c_handle_interrupt(void);
+// Register map, see pic_common/i2c_regs.h for the protocol
+#define RELAY_REG_STATUS 0x00 // R, bit 0 is limit switch 1, bit 1 is limit switch 2,
+                              // bits 2 and 3 are latched overcurrent trips on current sense 1 and 2
+#define RELAY_REG_CURR_SENSE_1 0x01 // R, 16-bit raw ADC reading
+#define RELAY_REG_CURR_SENSE_2 0x03 // R, 16-bit raw ADC reading
+#define RELAY_REG_CONTROL 0x05 // R/W, bit 0 is power, bit 1 is select. Power is held off while an
+                               // overcurrent trip is latched. Writing bit 2 (reads as 0) clears
+                               // latched trips before applying the rest.
+#define RELAY_REG_I2C_TIMING 0x06 // R, 4 bytes, see i2c_slave_read_timing()
+#define RELAY_REG_ADC_SAMPLES 0x0A // R, 16-bit conversion counts of current sense 1 then 2
+#define RELAY_REG_TRIP_THRESHOLD 0x0E // R/W, 16-bit raw ADC reading that counts as overcurrent
+#define RELAY_REG_TRIP_SAMPLES 0x10 // R/W, consecutive samples over the threshold before tripping
+#define RELAY_REG_WAVE_CONTROL 0x11 // R/W, bit 0 is capture done, bit 1 is the channel captured (0 for
+                                    // current sense 1). Writing bit 0 re-arms on the channel in bit 1.
+#define RELAY_REG_WAVE_LENGTH 0x12 // R, samples in the finished capture
+#define RELAY_REG_WAVE_DECIMATION 0x13 // R/W, capture every nth sample of the channel
+#define RELAY_REG_WAVE_INDEX 0x14 // R/W, first sample returned by RELAY_REG_WAVE_DATA
+#define RELAY_REG_WAVE_DATA 0x15 // R, the index the chunk was read from (0xFF if there is no
+                                 // finished capture) then WAVE_CHUNK_SIZE 8 bit samples
+#define RELAY_REG_STROKE_OPEN 0x1E // R, 16-bit ms of the last stroke that ended open, 0xFFFF if none yet
+#define RELAY_REG_STROKE_CLOSE 0x20 // R, 16-bit ms of the last stroke that ended closed, 0xFFFF if none yet
+#define RELAY_REG_TRANSITION_AGE 0x22 // R, 16-bit ms since the limit switches last changed, saturates
+#define RELAY_REGS_END 0x24 // one past the last register
 
-#endif /* I2C_H */
+// The register file needs I2C_REGS_MAX_SIZE of at least RELAY_REGS_END, it's set in the project's
+// macros (nbproject/configurations.xml). Raise both when adding registers.
+#if I2C_REGS_MAX_SIZE < RELAY_REGS_END
+#error "I2C_REGS_MAX_SIZE is too small for the relay register map"
+#endif
 
+#endif /* I2C_H */
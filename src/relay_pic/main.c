@@ -14,6 +14,11 @@ static void __interrupt() interrupt_handler(void) {
     if (SSP1IF == 1) {
        i2c_handle_interrupt();
     }
+    // The ADC has finished a conversion, store it and move on to the next channel
+    if (PIE1bits.ADIE == 1 && PIR1bits.ADIF == 1) {
+        adc_handle_interrupt();
+        PIR1bits.ADIF = 0;
+    }
     // Timer0 has overflowed - update millis() function
     // This happens approximately every 500us
     if (INTCONbits.TMR0IE == 1 && INTCONbits.TMR0IF == 1) {
@@ -69,6 +74,7 @@ void setup(void) {
 int main(int argc, char** argv) {
     setup();                    //Set up digital + analog I/O
     timer0_init();              //Initialize timer
+    adc_init();                 //Start sampling the current sense inputs in the background
     set_power_on();
     set_select_off();
     set_led_off();
@@ -87,8 +93,7 @@ int main(int argc, char** argv) {
             led_heartbeat();
         }
 
-        read_analog_inputs(CURR_SENSE_1);
-        read_analog_inputs(CURR_SENSE_2);
+        i2c_regs_publish(); // Make the latest readings available to the next I2C read
 
         read_dip_inputs(); //Check if dip switch input has changed, re-init i2c if so
     }
@@ -1,34 +1,119 @@
 #include <xc.h>
+#include "../pic_common/i2c_slave.h"
 #include "relay_general.h"
+#include "stroke.h"
+#include "waveform.h"
+
+// Channels sampled by the ADC sequencer, in the order they are converted
+static const uint8_t adc_channels[ADC_NUM_CHANNELS] = {CURR_SENSE_1, CURR_SENSE_2};
+
+// Written from the ADC interrupt, read with the interrupt masked so values can't tear
+static volatile uint16_t adc_results[ADC_NUM_CHANNELS];
+static volatile uint16_t adc_sample_counts[ADC_NUM_CHANNELS];
+static uint8_t adc_current = 0; // index of the channel being converted
+
+// Overcurrent trip, evaluated on every conversion. The settings are written from the I2C
+// interrupt and used by the ADC interrupt, which can't interrupt each other. The main loop only
+// reads them to publish the registers, with the I2C interrupt masked so the threshold can't
+// tear; trip_samples is a single byte and needs no masking.
+static volatile uint16_t trip_threshold = TRIP_DEFAULT_THRESHOLD;
+static volatile uint8_t trip_samples = TRIP_DEFAULT_SAMPLES;
+static uint8_t over_threshold_counts[ADC_NUM_CHANNELS]; // consecutive samples over the threshold
+static volatile uint8_t overcurrent_faults = 0; // bit per channel, latched until cleared over I2C
+
+static uint8_t adc_index(uint8_t port) {
+    return port == CURR_SENSE_1 ? 0 : 1;
+}
+
+void adc_init(void) {
+    adc_current = 0;
+    ADCON0 = 0x01 | (adc_channels[adc_current] << 2); // Turn ADC on, select first channel
+
+    // Timer1 counts the instruction clock (1 MHz) and CCP1's special event trigger resets it
+    // and starts a conversion every ADC_SAMPLE_PERIOD_US. The channel for the next conversion
+    // is selected as soon as the previous one finishes, so it gets the rest of the period
+    // (well over the acquisition time) to settle.
+    T1CONbits.TMR1CS = 0b00; // Fosc / 4
+    T1CONbits.T1CKPS = 0b00; // 1:1 prescaler
+    TMR1H = 0;
+    TMR1L = 0;
+    CCPR1H = (ADC_SAMPLE_PERIOD_US - 1) >> 8;
+    CCPR1L = (ADC_SAMPLE_PERIOD_US - 1) & 0xFF;
+    CCP1CONbits.CCP1M = 0b1011; // Compare mode, special event trigger. Leaves the CCP1 pin (RB3, DIP_4) alone.
+    T1CONbits.TMR1ON = 1;
+
+    PIR1bits.ADIF = 0;
+    PIE1bits.ADIE = 1;
+}
 
-uint16_t curr_sense_1 = 0;
-uint16_t curr_sense_2 = 0;
-uint16_t read_analog_inputs(uint8_t port) {
-    ADCON0 = 0x01 | (port << 2); // Turn ADC on, select port to read from
-    ADCON0 |= 1 << 1; // set b[1] "go" bit
-    uint8_t done_bit;
-    do { //wait for ADC to complete (go bit switches to 0 automatically when done)
-        done_bit = ADCON0 & (1 << 1);
-    } while (done_bit); //while go bit is on (AD conversion in progress)
-
-    uint16_t adc_result = ((uint16_t)ADRESH << 8) | ADRESL; //combine two 8bit values into a 16bit value
-    if (port == CURR_SENSE_1) {
-        curr_sense_1 = adc_result;
+void adc_handle_interrupt(void) {
+    uint16_t result = ((uint16_t)ADRESH << 8) | ADRESL; // combine two 8bit values into a 16bit value
+    adc_results[adc_current] = result;
+    adc_sample_counts[adc_current]++;
+
+    // Cut power ourselves if the current stays over the threshold, rather than waiting for
+    // towerside to notice at its polling rate
+    if (result >= trip_threshold) {
+        if (over_threshold_counts[adc_current] < 0xFF) {
+            over_threshold_counts[adc_current]++;
+        }
+        if (over_threshold_counts[adc_current] >= trip_samples && get_power()) {
+            set_power_off();
+            overcurrent_faults |= 1 << adc_current;
+        }
     } else {
-        curr_sense_2 = adc_result;
+        over_threshold_counts[adc_current] = 0;
     }
 
-    ADCON0 = 0x00; //Turn ADC off return;
+    waveform_handle_sample(adc_current, result);
 
-    return adc_result;
+    adc_current++;
+    if (adc_current == ADC_NUM_CHANNELS) {
+        adc_current = 0;
+        stroke_handle_tick(); // once per sweep is plenty, the limit switches are slow
+    }
+    ADCON0 = 0x01 | (adc_channels[adc_current] << 2); // Start acquiring the next channel
 }
 
 uint16_t get_analog_inputs(uint8_t port) {
-    if (port == CURR_SENSE_1) {
-        return curr_sense_1;
-    } else {
-        return curr_sense_2;
-    }
+    PIE1bits.ADIE = 0;
+    uint16_t result = adc_results[adc_index(port)];
+    PIE1bits.ADIE = 1;
+    return result;
+}
+
+uint16_t get_analog_sample_count(uint8_t port) {
+    PIE1bits.ADIE = 0;
+    uint16_t count = adc_sample_counts[adc_index(port)];
+    PIE1bits.ADIE = 1;
+    return count;
+}
+
+uint8_t get_overcurrent_faults(void) {
+    return overcurrent_faults;
+}
+
+void clear_overcurrent_faults(void) {
+    overcurrent_faults = 0;
+}
+
+uint16_t get_trip_threshold(void) {
+    i2c_slave_mask();
+    uint16_t threshold = trip_threshold;
+    i2c_slave_unmask();
+    return threshold;
+}
+
+void set_trip_threshold(uint16_t threshold) {
+    trip_threshold = threshold;
+}
+
+uint8_t get_trip_samples(void) {
+    return trip_samples;
+}
+
+void set_trip_samples(uint8_t samples) {
+    trip_samples = samples;
 }
 
 void set_power_on(void) {
@@ -97,3 +182,11 @@ bool get_lim1(void) {
 bool get_lim2(void) {
     return PORTAbits.RA6;
 }
+
+bool get_power(void) {
+    return LATAbits.LATA2;
+}
+
+bool get_select(void) {
+    return LATAbits.LATA3;
+}
@@ -8,10 +8,40 @@
 #define CURR_SENSE_1 1
 #define CURR_SENSE_2 0
 
-uint16_t read_analog_inputs(uint8_t port);
+#define ADC_NUM_CHANNELS 2
+// Time between conversions. Each channel is sampled every ADC_NUM_CHANNELS periods.
+#define ADC_SAMPLE_PERIOD_US 100
 
+// Overcurrent trip defaults: power is cut once a current sense reading has been at or above
+// the threshold for this many consecutive samples of that channel. The default threshold is
+// just under full scale (~4A), and 3 samples is 600us at ADC_SAMPLE_PERIOD_US.
+#define TRIP_DEFAULT_THRESHOLD 1000
+#define TRIP_DEFAULT_SAMPLES 3
+
+// Starts the ADC converting every channel round-robin in the background
+void adc_init(void);
+
+// should be called from the general ISR when a conversion completes
+void adc_handle_interrupt(void);
+
+// Latest reading of the channel
 uint16_t get_analog_inputs(uint8_t port);
 
+// Number of conversions of the channel so far, wraps around
+uint16_t get_analog_sample_count(uint8_t port);
+
+// Bit per channel (in conversion order) that has tripped on overcurrent. Faults stay latched,
+// and keep power from being turned back on, until they are cleared over I2C (RELAY_REG_CONTROL).
+uint8_t get_overcurrent_faults(void);
+void clear_overcurrent_faults(void);
+
+// Overcurrent trip configuration. The setters are for the I2C interrupt; the getters can be
+// called from anywhere, get_trip_threshold() masks the I2C interrupt to read it whole.
+uint16_t get_trip_threshold(void);
+void set_trip_threshold(uint16_t threshold);
+uint8_t get_trip_samples(void);
+void set_trip_samples(uint8_t samples);
+
 void set_power_on(void);
 
 void set_power_off(void);
@@ -30,6 +60,10 @@ bool get_lim1(void);
 
 bool get_lim2(void);
 
+bool get_power(void);
+
+bool get_select(void);
+
 //internal functions
 void set_power(bool out);
 void set_select(bool out);
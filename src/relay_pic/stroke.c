@@ -0,0 +1,77 @@
+#include <xc.h>
+#include "stroke.h"
+#include "relay_general.h"
+#include "timer.h"
+
+#define LIMS_OPEN 1 // only lim 1 pressed
+#define LIMS_CLOSED 2 // only lim 2 pressed
+
+// Only touched from the interrupt handler, so millis() can't tear here either. Reads from the
+// main loop mask the ADC interrupt, which drives the ticks.
+static uint8_t last_outputs = 0xFF; // power and select, 0xFF so the first tick starts a stroke
+static uint8_t last_lims = 0xFF;
+static uint8_t start_lims = 0; // where the valve was when the stroke started
+static bool stroking = false;
+static uint32_t stroke_start = 0;
+static uint32_t last_transition = 0;
+static uint16_t stroke_open_ms = STROKE_NONE;
+static uint16_t stroke_close_ms = STROKE_NONE;
+static uint16_t last_transition_age_ms = 0;
+
+static uint16_t ms_since(uint32_t start) {
+    uint32_t elapsed = millis() - start;
+    return elapsed > STROKE_MAX_MS ? STROKE_MAX_MS : (uint16_t)elapsed;
+}
+
+void stroke_handle_tick(void) {
+    uint8_t lims = (get_lim2() << 1) | get_lim1();
+    uint8_t outputs = (get_select() << 1) | get_power();
+
+    if (outputs != last_outputs) {
+        last_outputs = outputs;
+        stroking = true;
+        stroke_start = millis();
+        start_lims = lims;
+    }
+
+    if (lims == last_lims) {
+        last_transition_age_ms = ms_since(last_transition);
+        return;
+    }
+    last_lims = lims;
+    last_transition = millis();
+    last_transition_age_ms = 0;
+
+    // Arriving back where it started (or bouncing between switches) isn't a stroke
+    if (!stroking || lims == start_lims) {
+        return;
+    }
+    if (lims == LIMS_OPEN) {
+        stroke_open_ms = ms_since(stroke_start);
+        stroking = false;
+    } else if (lims == LIMS_CLOSED) {
+        stroke_close_ms = ms_since(stroke_start);
+        stroking = false;
+    }
+}
+
+uint16_t get_stroke_open_ms(void) {
+    PIE1bits.ADIE = 0;
+    uint16_t ms = stroke_open_ms;
+    PIE1bits.ADIE = 1;
+    return ms;
+}
+
+uint16_t get_stroke_close_ms(void) {
+    PIE1bits.ADIE = 0;
+    uint16_t ms = stroke_close_ms;
+    PIE1bits.ADIE = 1;
+    return ms;
+}
+
+uint16_t get_last_transition_age_ms(void) {
+    PIE1bits.ADIE = 0;
+    uint16_t ms = last_transition_age_ms;
+    PIE1bits.ADIE = 1;
+    return ms;
+}
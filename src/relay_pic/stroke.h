@@ -0,0 +1,21 @@
+#ifndef STROKE_H
+#define STROKE_H
+
+#include <stdint.h>
+
+// Valve travel timing. Changes to the power and select relays start a stroke, and the limit
+// switches reaching a different end position finish it.
+#define STROKE_NONE 0xFFFF // no stroke measured yet
+#define STROKE_MAX_MS 0xFFFE // longer strokes and ages saturate here
+
+// should be called from the ADC interrupt regularly, the period sets the resolution
+void stroke_handle_tick(void);
+
+// Duration of the most recent stroke that ended open (lim 1) or closed (lim 2), in ms
+uint16_t get_stroke_open_ms(void);
+uint16_t get_stroke_close_ms(void);
+
+// Time since the limit switches last changed, in ms
+uint16_t get_last_transition_age_ms(void);
+
+#endif /* STROKE_H */
@@ -0,0 +1,87 @@
+#include "waveform.h"
+#include "relay_general.h"
+
+// 8 bit samples (the top of the 10 bit reading) so the buffer fits in a RAM bank
+static uint8_t samples[WAVE_NUM_SAMPLES];
+static uint8_t head = 0; // where the next sample goes
+static uint8_t filled = 0; // samples recorded since arming, saturates at WAVE_NUM_SAMPLES
+static uint8_t remaining = 0; // samples left to record after the trigger, 0 while waiting
+static volatile uint8_t decimation = 1; // set from the I2C interrupt, published from the main loop
+static uint8_t decimation_count = 0;
+static uint8_t channel = 1; // CURR_SENSE_2, the one towerside reports for ignition boards
+static bool last_power = false;
+static volatile bool done = false;
+
+void waveform_handle_sample(uint8_t sample_channel, uint16_t result) {
+    if (sample_channel != channel || done) {
+        return;
+    }
+
+    bool power = get_power();
+    if (power && !last_power && remaining == 0) {
+        remaining = WAVE_NUM_SAMPLES - WAVE_PRETRIGGER_SAMPLES;
+        decimation_count = 0; // record the trigger sample itself
+    }
+    last_power = power;
+
+    if (decimation_count != 0) {
+        decimation_count--;
+        return;
+    }
+    decimation_count = decimation - 1;
+
+    samples[head] = result >> 2;
+    head = (head + 1) & (WAVE_NUM_SAMPLES - 1);
+    if (filled < WAVE_NUM_SAMPLES) {
+        filled++;
+    }
+    if (remaining != 0) {
+        remaining--;
+        if (remaining == 0) {
+            done = true;
+        }
+    }
+}
+
+void waveform_arm(uint8_t new_channel) {
+    channel = new_channel;
+    head = 0;
+    filled = 0;
+    remaining = 0;
+    decimation_count = 0;
+    last_power = get_power(); // only a fresh power on triggers
+    done = false;
+}
+
+bool waveform_done(void) {
+    return done;
+}
+
+uint8_t waveform_channel(void) {
+    return channel;
+}
+
+uint8_t waveform_length(void) {
+    return done ? filled : 0;
+}
+
+uint8_t waveform_decimation(void) {
+    return decimation;
+}
+
+void waveform_set_decimation(uint8_t new_decimation) {
+    decimation = new_decimation == 0 ? 1 : new_decimation;
+}
+
+bool waveform_read(uint8_t index, uint8_t *dest) {
+    if (!done) {
+        return false;
+    }
+    // The ring is frozen while done, so this can run outside the interrupt
+    uint8_t oldest = (head - filled) & (WAVE_NUM_SAMPLES - 1);
+    for (uint8_t i = 0; i < WAVE_CHUNK_SIZE; i++) {
+        uint16_t n = (uint16_t)index + i;
+        dest[i] = n < filled ? samples[(oldest + n) & (WAVE_NUM_SAMPLES - 1)] : 0;
+    }
+    return done; // re-armed part way through if this changed
+}
@@ -0,0 +1,39 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Triggered capture of one current sense channel. Samples are kept in a ring while armed,
+// and turning power on triggers the capture: it keeps WAVE_PRETRIGGER_SAMPLES of history,
+// records the rest of the buffer and then freezes until it is re-armed.
+#define WAVE_NUM_SAMPLES 64 // must be a power of two
+#define WAVE_PRETRIGGER_SAMPLES 16
+#define WAVE_CHUNK_SIZE 8 // samples per read of the data register
+
+// should be called from the ADC interrupt with every conversion, channel is the index in
+// conversion order
+void waveform_handle_sample(uint8_t channel, uint16_t result);
+
+// Restarts the capture on the given channel, dropping anything recorded so far
+void waveform_arm(uint8_t channel);
+
+// Whether a capture has finished and is waiting to be read
+bool waveform_done(void);
+
+uint8_t waveform_channel(void);
+
+// Number of samples in a finished capture, the trigger is WAVE_NUM_SAMPLES -
+// WAVE_PRETRIGGER_SAMPLES from the end. Only the pre-trigger part can come up short.
+uint8_t waveform_length(void);
+
+// Record every nth sample of the channel. The setter is for the I2C interrupt, the getter can be
+// called from anywhere since the setting is a single byte.
+uint8_t waveform_decimation(void);
+void waveform_set_decimation(uint8_t decimation);
+
+// Copies WAVE_CHUNK_SIZE samples of a finished capture, oldest first, starting at sample
+// index. Returns false if there is no finished capture, or it was re-armed while copying.
+bool waveform_read(uint8_t index, uint8_t *dest);
+
+#endif /* WAVEFORM_H */
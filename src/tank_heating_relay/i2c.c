@@ -1,121 +1,97 @@
 #include "i2c.h"
 #include "relay_general.h"
+#include "thermostat.h"
 
-uint16_t i2cSlaveRecv; // Data received on i2c
-uint16_t i2cSlaveSend; // Data to be sent on i2c
-
-void i2c_slave_init(uint16_t address) {
-    SSPSTAT = 0x80;
-    SSPADDbits.SSPADD = address << 1; // 7 bit addressing, LSB is unused
-    SSPCON = 0x36;
-    SSPCON2 = 0x01;
-    TRISB1 = 1; // SDA
-    TRISB4 = 1; // SCL
-    GIE = 1;
-    PEIE = 1;
-    SSP1IF = 0;
-    SSP1IE = 1;
-}
-
-uint8_t i2c_reg_select = 0;
-
-#define TIMEOUT 200
-void i2c_handle_interrupt(void) {
-    uint16_t temp;
-    uint16_t timeout = 0;
-    SSPCONbits.CKP = 0;
-
-    SSP1IF = 0;
-
-    // If overflow or collision.
-    if ((SSPCONbits.SSPOV) || (SSPCONbits.WCOL)) {
-        temp = SSPBUF; // Read the previous value to clear the buffer
-        SSPCONbits.SSPOV = 0; // Clear the overflow flag
-        SSPCONbits.WCOL = 0; // Clear the collision bit
-        SSPCONbits.CKP = 1;
-        return;
-    }
+static void read_thermistor(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_inputs(CHANNEL_THERMISTOR));
+}
 
-    // If last byte was Address + write
-    if (!SSPSTATbits.D_nA && !SSPSTATbits.R_nW) {
-        while (!BF && timeout < TIMEOUT) {
-            timeout++;
-        }
-        temp = SSP1BUF;
-        BF = 0;
-        SSPCONbits.CKP = 1;
-        while (!BF && timeout < TIMEOUT) {
-            timeout++;
-        }
-        i2cSlaveRecv = SSP1BUF;
-        if (timeout < TIMEOUT) {
-            // LSB is power
-            if (i2cSlaveRecv & 1) {
-                set_power_on();
-            } else {
-                set_power_off();
-            }
-            // Bit 1-3 are register select
-            i2c_reg_select = (i2cSlaveRecv >> 1) & 7;
-        }
-        SSPCONbits.CKP = 1;
-        BF = 0;
-        // We already set this above but for some reason we need to set it here too
-        SSP1IF = 0;
-    }
-    // If this is a read
-    else if (SSPSTATbits.R_nW) {
-        static uint8_t read_pointer;
-        // If this is the first byte in a read
-        if (!SSPSTATbits.D_nA) {
-            read_pointer = 0;
-        }
-        temp = SSPBUF;
-
-        if(read_pointer == 0) {
-            switch(i2c_reg_select) {
-            case 0:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_THERMISTOR) & 0xFF);
-                break;
-            case 1:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_CURR_SENSE) & 0xFF);
-                break;
-            case 2:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_24V_SENSE) & 0xFF);
-                break;
-            case 3:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_KELVIN_N) & 0xFF);
-                break;
-            case 4:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_KELVIN_P) & 0xFF);
-                break;
-                default:
-                SSPBUF = 0;
-            }
-        } else if (read_pointer == 1) {
-            switch(i2c_reg_select) {
-            case 0:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_THERMISTOR) >> 8);
-                break;
-            case 1:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_CURR_SENSE) >> 8);
-                break;
-            case 2:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_24V_SENSE) >> 8);
-                break;
-            case 3:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_KELVIN_N) >> 8);
-                break;
-            case 4:
-                SSPBUF = (uint8_t)(get_analog_inputs(CHANNEL_KELVIN_P) >> 8);
-                break;
-            default:
-                SSPBUF = 0;
-            }
-        }
-
-        read_pointer++;
-        SSPCONbits.CKP = 1;
+static void read_curr_sense(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_inputs(CHANNEL_CURR_SENSE));
+}
+
+static void read_24v_sense(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_inputs(CHANNEL_24V_SENSE));
+}
+
+static void read_kelvin_n(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_inputs(CHANNEL_KELVIN_N));
+}
+
+static void read_kelvin_p(uint8_t *dest) {
+    i2c_regs_put_u16(dest, get_analog_inputs(CHANNEL_KELVIN_P));
+}
+
+static void read_min_max(uint8_t *dest) {
+    static const uint8_t ports[] = {
+        CHANNEL_THERMISTOR, CHANNEL_CURR_SENSE, CHANNEL_24V_SENSE, CHANNEL_KELVIN_N, CHANNEL_KELVIN_P};
+    for (uint8_t i = 0; i < sizeof(ports); i++) {
+        i2c_regs_put_u16(dest + 4 * i, get_analog_min(ports[i]));
+        i2c_regs_put_u16(dest + 4 * i + 2, get_analog_max(ports[i]));
     }
-    SSPCONbits.CKP = 1;
 }
+
+static void read_control(uint8_t *dest) {
+    dest[0] = (thermostat_limit_tripped() << 3) | (thermostat_heat_requested() << 2)
+              | (thermostat_enabled() << 1) | get_power();
+}
+
+static void write_control(const uint8_t *src) {
+    // LSB is power, second bit is thermostat enable, third clears a tripped limit. The main loop
+    // switches the heater.
+    thermostat_command(src[0] & 1, (src[0] >> 1) & 1, (src[0] >> 2) & 1);
+}
+
+static void read_setpoint(uint8_t *dest) {
+    i2c_regs_put_u16(dest, thermostat_get_setpoint());
+}
+
+static void write_setpoint(const uint8_t *src) {
+    thermostat_set_setpoint(i2c_regs_get_u16(src));
+}
+
+static void read_hysteresis(uint8_t *dest) {
+    i2c_regs_put_u16(dest, thermostat_get_hysteresis());
+}
+
+static void write_hysteresis(const uint8_t *src) {
+    thermostat_set_hysteresis(i2c_regs_get_u16(src));
+}
+
+static void read_current_limit(uint8_t *dest) {
+    i2c_regs_put_u16(dest, thermostat_get_current_limit());
+}
+
+static void write_current_limit(const uint8_t *src) {
+    thermostat_set_current_limit(i2c_regs_get_u16(src));
+}
+
+static void read_kelvin_limit(uint8_t *dest) {
+    i2c_regs_put_u16(dest, thermostat_get_kelvin_limit());
+}
+
+static void write_kelvin_limit(const uint8_t *src) {
+    thermostat_set_kelvin_limit(i2c_regs_get_u16(src));
+}
+
+static void read_duty(uint8_t *dest) {
+    dest[0] = thermostat_duty();
+}
+
+// Must stay in the order of the addresses in i2c.h
+const i2c_reg_t i2c_registers[] = {
+    {2, read_thermistor, NULL}, // HEATER_REG_THERMISTOR
+    {2, read_curr_sense, NULL}, // HEATER_REG_CURR_SENSE
+    {2, read_24v_sense, NULL}, // HEATER_REG_24V_SENSE
+    {2, read_kelvin_n, NULL}, // HEATER_REG_KELVIN_N
+    {2, read_kelvin_p, NULL}, // HEATER_REG_KELVIN_P
+    {1, read_control, write_control}, // HEATER_REG_CONTROL
+    {4, i2c_slave_read_timing, NULL}, // HEATER_REG_I2C_TIMING
+    {20, read_min_max, NULL}, // HEATER_REG_MIN_MAX
+    {2, read_setpoint, write_setpoint}, // HEATER_REG_SETPOINT
+    {2, read_hysteresis, write_hysteresis}, // HEATER_REG_HYSTERESIS
+    {2, read_current_limit, write_current_limit}, // HEATER_REG_CURRENT_LIMIT
+    {2, read_kelvin_limit, write_kelvin_limit}, // HEATER_REG_KELVIN_LIMIT
+    {1, read_duty, NULL}, // HEATER_REG_DUTY
+};
+const uint8_t i2c_num_registers = sizeof(i2c_registers) / sizeof(i2c_registers[0]);
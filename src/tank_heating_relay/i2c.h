@@ -8,10 +8,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-// Initializes i2c module
-void i2c_slave_init(uint16_t address);
+#include "../pic_common/i2c_regs.h"
+#include "../pic_common/i2c_slave.h"
 
-// interrupt handling of i2c signal
-void i2c_handle_interrupt(void);
+// Register map, see pic_common/i2c_regs.h for the protocol. The analog registers are
+// 16-bit oversampled and filtered 12 bit readings and are contiguous, so one 10 byte read
+// starting at HEATER_REG_THERMISTOR returns every channel.
+#define HEATER_REG_THERMISTOR 0x00 // R
+#define HEATER_REG_CURR_SENSE 0x02 // R
+#define HEATER_REG_24V_SENSE 0x04 // R
+#define HEATER_REG_KELVIN_N 0x06 // R
+#define HEATER_REG_KELVIN_P 0x08 // R
+#define HEATER_REG_CONTROL 0x0A // R/W, bit 0 is power, bit 1 enables the thermostat, writing bit 2
+                                // clears a tripped safety limit. Reads back the heater output in
+                                // bit 0, thermostat enabled in bit 1, heat requested in bit 2 and
+                                // a tripped safety limit in bit 3.
+#define HEATER_REG_I2C_TIMING 0x0B // R, 4 bytes, see i2c_slave_read_timing()
+#define HEATER_REG_MIN_MAX 0x0F // R, 20 bytes, 16-bit min then max of each analog channel over
+                                // the last MINMAX_WINDOW_MS, in the same order as above
+// Thermostat settings, raw 12 bit readings, see thermostat.h
+#define HEATER_REG_SETPOINT 0x23 // R/W, 16-bit
+#define HEATER_REG_HYSTERESIS 0x25 // R/W, 16-bit
+#define HEATER_REG_CURRENT_LIMIT 0x27 // R/W, 16-bit
+#define HEATER_REG_KELVIN_LIMIT 0x29 // R/W, 16-bit
+#define HEATER_REG_DUTY 0x2B // R, percent of the last DUTY_WINDOW_MS the heater was on
+#define HEATER_REGS_END 0x2C // one past the last register
+
+// The register file needs I2C_REGS_MAX_SIZE of at least HEATER_REGS_END, it's set in the
+// project's macros (nbproject/configurations.xml). Raise both when adding registers.
+#if I2C_REGS_MAX_SIZE < HEATER_REGS_END
+#error "I2C_REGS_MAX_SIZE is too small for the heater register map"
+#endif
 
 #endif /* I2C_H */
@@ -4,6 +4,7 @@
 
 #include "i2c.h"
 #include "relay_general.h"
+#include "thermostat.h"
 #include "timer.h"
 
 #define MAX_LOOP_TIME_DIFF_CONST 500
@@ -88,11 +89,9 @@ int main(int argc, char **argv) {
             led_heartbeat();
         }
 
-        read_analog_inputs(CHANNEL_THERMISTOR);
-        read_analog_inputs(CHANNEL_CURR_SENSE);
-        read_analog_inputs(CHANNEL_24V_SENSE);
-        read_analog_inputs(CHANNEL_KELVIN_N);
-        read_analog_inputs(CHANNEL_KELVIN_P);
+        sample_analog_inputs();
+        thermostat_update(); // Switch the heater on the new readings
+        i2c_regs_publish(); // Make the new readings available to the next I2C read
 
         read_dip_inputs(); // Check if dip switch input has changed, re-init i2c if so
     }
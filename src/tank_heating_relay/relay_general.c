@@ -1,12 +1,42 @@
 #include <xc.h>
 
 #include "relay_general.h"
+#include "timer.h"
 
-static uint16_t curr_sense = 0;
-static uint16_t thermistor = 0;
-static uint16_t _24v_sense = 0;
-static uint16_t kelvin_n = 0;
-static uint16_t kelvin_p = 0;
+// Every channel is oversampled by OVERSAMPLE_COUNT and decimated, which averages out noise
+// above the block rate (so it can't alias into our 100ms polling) and gives 2 extra bits.
+// Each decimated reading then goes through a first order IIR low pass filter.
+#define OVERSAMPLE_COUNT 16 // 10 bit samples per 12 bit reading
+#define OVERSAMPLE_SHIFT 2 // sum of OVERSAMPLE_COUNT samples >> 2 = 12 bit reading
+#define IIR_SHIFT 2 // each new reading is weighted 1 / 2^IIR_SHIFT
+#define IIR_FRAC_BITS 4 // fractional bits kept in the filter state
+
+typedef struct {
+    uint16_t accumulator; // sum of the raw samples in the current block
+    uint8_t count; // number of samples in the current block
+    uint16_t filtered; // 12 bit reading with IIR_FRAC_BITS fractional bits
+    uint16_t window_min; // over the min/max window in progress
+    uint16_t window_max;
+    uint16_t min; // over the last complete min/max window
+    uint16_t max;
+} analog_channel_t;
+
+// ADC channels in the order they are sampled, indexes into analog_channels
+static const uint8_t analog_ports[ANALOG_NUM_CHANNELS] = {
+    CHANNEL_THERMISTOR, CHANNEL_CURR_SENSE, CHANNEL_24V_SENSE, CHANNEL_KELVIN_N, CHANNEL_KELVIN_P};
+
+static analog_channel_t analog_channels[ANALOG_NUM_CHANNELS];
+static uint32_t window_start = 0;
+static bool filters_primed = false;
+
+static analog_channel_t *get_channel(uint8_t port) {
+    for (uint8_t i = 0; i < ANALOG_NUM_CHANNELS; i++) {
+        if (analog_ports[i] == port) {
+            return &analog_channels[i];
+        }
+    }
+    return NULL;
+}
 
 uint16_t read_analog_inputs(uint8_t port) {
     ADCON0 = 0x01 | (port << 2); // Turn ADC on, select port to read from
@@ -18,36 +48,82 @@ uint16_t read_analog_inputs(uint8_t port) {
 
     uint16_t adc_result =
         ((uint16_t)ADRESH << 8) | ADRESL; // combine two 8bit values into a 16bit value
-    if (port == CHANNEL_THERMISTOR) {
-        thermistor = adc_result;
-    } else if (port == CHANNEL_CURR_SENSE) {
-        curr_sense = adc_result;
-    } else if (port == CHANNEL_24V_SENSE) {
-        _24v_sense = adc_result;
-    } else if (port == CHANNEL_KELVIN_N) {
-        kelvin_n = adc_result;
-    } else if (port == CHANNEL_KELVIN_P) {
-        kelvin_p = adc_result;
-    }
 
     ADCON0 = 0x00; // Turn ADC off return;
 
     return adc_result;
 }
 
+static void add_sample(analog_channel_t *channel, uint16_t sample) {
+    channel->accumulator += sample;
+    channel->count++;
+    if (channel->count < OVERSAMPLE_COUNT) {
+        return;
+    }
+
+    uint16_t reading = channel->accumulator >> OVERSAMPLE_SHIFT;
+    channel->accumulator = 0;
+    channel->count = 0;
+
+    // filtered += (reading - filtered) / 2^IIR_SHIFT, without going through signed 32 bit math
+    uint16_t target = reading << IIR_FRAC_BITS;
+    if (!filters_primed) {
+        // Start from the first reading rather than ramping up from 0
+        channel->filtered = target;
+        channel->window_min = reading;
+        channel->window_max = reading;
+    } else if (target > channel->filtered) {
+        channel->filtered += (target - channel->filtered) >> IIR_SHIFT;
+    } else {
+        channel->filtered -= (channel->filtered - target) >> IIR_SHIFT;
+    }
+
+    if (reading < channel->window_min) {
+        channel->window_min = reading;
+    }
+    if (reading > channel->window_max) {
+        channel->window_max = reading;
+    }
+}
+
+void sample_analog_inputs(void) {
+    for (uint8_t i = 0; i < ANALOG_NUM_CHANNELS; i++) {
+        add_sample(&analog_channels[i], read_analog_inputs(analog_ports[i]));
+    }
+    // Every channel finishes its block on the same pass
+    if (analog_channels[0].count == 0) {
+        filters_primed = true;
+    }
+
+    if (millis() - window_start >= MINMAX_WINDOW_MS) {
+        window_start = millis();
+        for (uint8_t i = 0; i < ANALOG_NUM_CHANNELS; i++) {
+            analog_channel_t *channel = &analog_channels[i];
+            channel->min = channel->window_min;
+            channel->max = channel->window_max;
+            channel->window_min = 0xFFFF;
+            channel->window_max = 0;
+        }
+    }
+}
+
 uint16_t get_analog_inputs(uint8_t port) {
-    if (port == CHANNEL_THERMISTOR) {
-        return thermistor;
-    } else if (port == CHANNEL_CURR_SENSE) {
-        return curr_sense;
-    } else if (port == CHANNEL_24V_SENSE) {
-        return _24v_sense;
-    } else if (port == CHANNEL_KELVIN_N) {
-        return kelvin_n;
-    } else if (port == CHANNEL_KELVIN_P) {
-        return kelvin_p;
+    analog_channel_t *channel = get_channel(port);
+    if (channel == NULL) {
+        return 0;
     }
-    return 0;
+    // Round off the fractional bits
+    return (channel->filtered + (1 << (IIR_FRAC_BITS - 1))) >> IIR_FRAC_BITS;
+}
+
+uint16_t get_analog_min(uint8_t port) {
+    analog_channel_t *channel = get_channel(port);
+    return channel == NULL ? 0 : channel->min;
+}
+
+uint16_t get_analog_max(uint8_t port) {
+    analog_channel_t *channel = get_channel(port);
+    return channel == NULL ? 0 : channel->max;
 }
 
 void set_power_on(void) {
@@ -92,3 +168,7 @@ void led_heartbeat(void) {
         led_on = true;
     }
 }
+
+bool get_power(void) {
+    return LATAbits.LATA2;
+}
@@ -11,10 +11,23 @@
 #define CHANNEL_KELVIN_N 9
 #define CHANNEL_KELVIN_P 10
 
+#define ANALOG_NUM_CHANNELS 5
+// Period the reported min/max readings are taken over, matches towerside's polling rate
+#define MINMAX_WINDOW_MS 100
+
+// Single blocking conversion of a channel, returns the raw 10 bit reading
 uint16_t read_analog_inputs(uint8_t port);
 
+// Samples every channel once and updates their filters, call this from the main loop
+void sample_analog_inputs(void);
+
+// Oversampled and filtered reading of a channel, 12 bits
 uint16_t get_analog_inputs(uint8_t port);
 
+// Lowest and highest oversampled reading over the last MINMAX_WINDOW_MS, 12 bits
+uint16_t get_analog_min(uint8_t port);
+uint16_t get_analog_max(uint8_t port);
+
 void set_power_on(void);
 
 void set_power_off(void);
@@ -25,6 +38,8 @@ void set_led_off(void);
 
 void led_heartbeat(void);
 
+bool get_power(void);
+
 //internal functions
 void set_power(bool out);
 void set_led(bool out);
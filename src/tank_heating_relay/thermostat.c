@@ -0,0 +1,133 @@
+#include <xc.h>
+
+#include "../pic_common/i2c_slave.h"
+#include "relay_general.h"
+#include "thermostat.h"
+#include "timer.h"
+
+// Settings are written from the I2C interrupt, so the main loop reads them with it masked
+static uint16_t setpoint = THERMOSTAT_DEFAULT_SETPOINT;
+static uint16_t hysteresis = THERMOSTAT_DEFAULT_HYSTERESIS;
+static uint16_t current_limit = THERMOSTAT_DEFAULT_CURRENT_LIMIT;
+static uint16_t kelvin_limit = THERMOSTAT_DEFAULT_KELVIN_LIMIT;
+static volatile bool heat_requested = false;
+static volatile bool enabled = false;
+static volatile bool limit_tripped = false;
+
+static uint32_t last_update = 0;
+static uint32_t window_start = 0;
+static uint32_t window_on_ms = 0; // time on so far in the duty window in progress
+static uint8_t duty = 0;
+
+static bool over_limits(void) {
+    uint16_t kelvin_p = get_analog_inputs(CHANNEL_KELVIN_P);
+    uint16_t kelvin_n = get_analog_inputs(CHANNEL_KELVIN_N);
+    uint16_t kelvin = kelvin_p > kelvin_n ? kelvin_p - kelvin_n : 0;
+    return get_analog_inputs(CHANNEL_CURR_SENSE) > current_limit || kelvin > kelvin_limit;
+}
+
+void thermostat_update(void) {
+    i2c_slave_mask();
+    uint32_t on_above = (uint32_t)setpoint + hysteresis;
+    uint16_t off_at = setpoint;
+    bool heat = heat_requested && !limit_tripped;
+    bool thermostat = enabled;
+    if (heat && get_power() && over_limits()) {
+        limit_tripped = true; // stays off until the next command
+        heat = false;
+    }
+    i2c_slave_unmask();
+
+    if (!heat) {
+        set_power_off();
+    } else if (!thermostat) {
+        set_power_on();
+    } else {
+        uint16_t thermistor = get_analog_inputs(CHANNEL_THERMISTOR);
+        if (thermistor > on_above) {
+            set_power_on();
+        } else if (thermistor <= off_at) {
+            set_power_off();
+        } // in between, keep doing whatever we were doing
+    }
+
+    uint32_t now = millis();
+    if (get_power()) {
+        window_on_ms += now - last_update;
+    }
+    last_update = now;
+    if (now - window_start >= DUTY_WINDOW_MS) {
+        uint32_t percent = window_on_ms * 100 / (now - window_start);
+        duty = percent > 100 ? 100 : (uint8_t)percent;
+        window_start = now;
+        window_on_ms = 0;
+    }
+}
+
+void thermostat_command(bool heat, bool enable, bool clear_trip) {
+    heat_requested = heat;
+    enabled = enable;
+    if (clear_trip) {
+        limit_tripped = false;
+    }
+}
+
+bool thermostat_heat_requested(void) {
+    return heat_requested;
+}
+
+bool thermostat_enabled(void) {
+    return enabled;
+}
+
+bool thermostat_limit_tripped(void) {
+    return limit_tripped;
+}
+
+uint16_t thermostat_get_setpoint(void) {
+    i2c_slave_mask();
+    uint16_t value = setpoint;
+    i2c_slave_unmask();
+    return value;
+}
+
+void thermostat_set_setpoint(uint16_t new_setpoint) {
+    setpoint = new_setpoint;
+}
+
+uint16_t thermostat_get_hysteresis(void) {
+    i2c_slave_mask();
+    uint16_t value = hysteresis;
+    i2c_slave_unmask();
+    return value;
+}
+
+void thermostat_set_hysteresis(uint16_t new_hysteresis) {
+    hysteresis = new_hysteresis;
+}
+
+uint16_t thermostat_get_current_limit(void) {
+    i2c_slave_mask();
+    uint16_t value = current_limit;
+    i2c_slave_unmask();
+    return value;
+}
+
+void thermostat_set_current_limit(uint16_t limit) {
+    current_limit = limit;
+}
+
+uint16_t thermostat_get_kelvin_limit(void) {
+    i2c_slave_mask();
+    uint16_t value = kelvin_limit;
+    i2c_slave_unmask();
+    return value;
+}
+
+void thermostat_set_kelvin_limit(uint16_t limit) {
+    kelvin_limit = limit;
+}
+
+uint8_t thermostat_duty(void) {
+    return duty;
+}
@@ -0,0 +1,50 @@
+#ifndef THERMOSTAT_H
+#define THERMOSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Hysteresis thermostat on the filtered thermistor reading. All thresholds are raw 12 bit
+// readings. The thermistor is an NTC on the low side of its divider, so the reading falls as
+// the tank warms up: the heater turns on once the reading rises hysteresis above the setpoint
+// and off once it is back down to the setpoint.
+#define THERMOSTAT_DEFAULT_SETPOINT 0x0FFF // coldest possible, never heats until configured
+#define THERMOSTAT_DEFAULT_HYSTERESIS 16
+// Safety limits, checked whether or not the thermostat is enabled. towerside sends its own
+// along with the setpoint, these only cover a board that hasn't heard from it yet.
+#define THERMOSTAT_DEFAULT_CURRENT_LIMIT 1000 // current sense reading, 10A
+#define THERMOSTAT_DEFAULT_KELVIN_LIMIT 3693 // kelvin P minus kelvin N reading, 26V
+
+// Duty cycle is reported over this window
+#define DUTY_WINDOW_MS 10000
+
+// Runs the control loop on the latest readings, call this from the main loop after
+// sample_analog_inputs()
+void thermostat_update(void);
+
+// Operator command. heat allows the heater to be on at all; with enable the thermostat
+// switches it, otherwise it just follows heat. A tripped limit stays tripped through repeated
+// commands until clear_trip is set.
+void thermostat_command(bool heat, bool enable, bool clear_trip);
+
+bool thermostat_heat_requested(void);
+bool thermostat_enabled(void);
+
+// Whether a safety limit has turned the heater off and it hasn't been cleared since
+bool thermostat_limit_tripped(void);
+
+// Configuration. The setters are for the I2C interrupt; the getters can be called from anywhere,
+// they mask the I2C interrupt so a setting isn't read half written.
+uint16_t thermostat_get_setpoint(void);
+void thermostat_set_setpoint(uint16_t setpoint);
+uint16_t thermostat_get_hysteresis(void);
+void thermostat_set_hysteresis(uint16_t hysteresis);
+uint16_t thermostat_get_current_limit(void);
+void thermostat_set_current_limit(uint16_t limit);
+uint16_t thermostat_get_kelvin_limit(void);
+void thermostat_set_kelvin_limit(uint16_t limit);
+
+// Percent of the last DUTY_WINDOW_MS the heater was on
+uint8_t thermostat_duty(void);
+
+#endif /* THERMOSTAT_H */
@@ -4,8 +4,10 @@
 #include <stdint.h>
 
 #include "common/mock_arduino.hpp"
+#include "common/scale.hpp"
 #include "common/shared_types.hpp"
 #include "errors.hpp"
+#include "thermistor.hpp"
 
 namespace actuator {
 
@@ -17,8 +19,119 @@ public:
   // but it can be modified based on specific actuator requirements
 };
 
-class I2C: public Actuator {
+// Access to the register file that every PIC board exposes over I2C. The first byte
+// written selects a register address, and reads burst from that address onwards.
+// See src/pic_common/i2c_regs.h for the slave side.
+class RegisterDevice: public Actuator {
+protected:
   uint8_t slave_address; // slave address we are controlling
+
+  RegisterDevice(uint8_t slave_address):
+    slave_address{slave_address} {}
+
+  bool write_register(uint8_t reg, uint8_t value) {
+    Wire.beginTransmission(slave_address);
+    bool healthy = true;
+    healthy &= Wire.write(reg) == 1; // returns the number of bytes written, should be 1
+    healthy &= Wire.write(value) == 1;
+    healthy &= Wire.endTransmission() == 0; // returns non-zero value if there was an error
+    healthy &= !Wire.getWireTimeoutFlag(); // make sure timeout flag is not set
+    if (!healthy) {
+      errors::push(slave_address, ErrorCode::I2CWriteError);
+    }
+    Wire.clearWireTimeoutFlag(); // if the flag was set, clear it for next time
+    return healthy;
+  }
+
+  // Writes len consecutive bytes starting at register reg. Multi-byte registers only take
+  // effect once their last byte arrives.
+  bool write_registers(uint8_t reg, const uint8_t *src, uint8_t len) {
+    Wire.beginTransmission(slave_address);
+    bool healthy = true;
+    healthy &= Wire.write(reg) == 1; // returns the number of bytes written, should be 1
+    for (uint8_t i = 0; i < len; i++) {
+      healthy &= Wire.write(src[i]) == 1;
+    }
+    healthy &= Wire.endTransmission() == 0; // returns non-zero value if there was an error
+    healthy &= !Wire.getWireTimeoutFlag(); // make sure timeout flag is not set
+    if (!healthy) {
+      errors::push(slave_address, ErrorCode::I2CWriteError);
+    }
+    Wire.clearWireTimeoutFlag(); // if the flag was set, clear it for next time
+    return healthy;
+  }
+
+  // Reads len consecutive bytes starting at register reg
+  bool read_registers(uint8_t reg, uint8_t *dest, uint8_t len) {
+    Wire.beginTransmission(slave_address);
+    bool healthy = true;
+    healthy &= Wire.write(reg) == 1; // returns the number of bytes written, should be 1
+    healthy &= Wire.endTransmission() == 0; // returns non-zero value if there was an error
+    healthy &= !Wire.getWireTimeoutFlag(); // make sure timeout flag is not set
+    Wire.clearWireTimeoutFlag(); // if the flag was set, clear it for next time
+    if (!healthy) {
+      errors::push(slave_address, ErrorCode::I2CWriteError);
+      return false;
+    }
+    uint8_t received = Wire.requestFrom(slave_address, len); // returns number of bytes received
+    if (received != len) {
+      errors::push(slave_address, ErrorCode::I2CReadError);
+      return false;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      dest[i] = Wire.read();
+    }
+    return true;
+  }
+
+public:
+  uint8_t get_address() const {
+    return slave_address;
+  }
+
+protected:
+  // Registers are little endian
+  static uint16_t to_u16(const uint8_t *src) {
+    return (static_cast<uint16_t>(src[1]) << 8) | src[0];
+  }
+  static void from_u16(uint16_t value, uint8_t *dest) {
+    dest[0] = value & 0xFF;
+    dest[1] = value >> 8;
+  }
+};
+
+// State of the current waveform capture on a relay board
+struct WaveformStatus {
+  bool done; // a capture is finished and waiting to be read
+  uint8_t channel; // current sense channel captured, same numbering as get_current_ma
+  uint8_t length; // samples in the capture
+  uint8_t decimation; // the capture holds every nth sample
+};
+
+// Travel times of the last full strokes of a valve, SENSOR_ERR_VAL until there has been one
+struct StrokeTimes {
+  uint16_t open_ms;
+  uint16_t close_ms;
+};
+
+class I2C: public RegisterDevice {
+  // adc / 1024 (10bit) * 4096mV (vref) / 10mohm / 100 adc scaler * 1000 mV/V
+  typedef scale::Scale<1023, 4, 1> CurrentMa;
+
+  // Register map, must match src/relay_pic/i2c.h
+  static const uint8_t REG_STATUS = 0x00;
+  static const uint8_t REG_CURR_SENSE_1 = 0x01;
+  static const uint8_t REG_CONTROL = 0x05;
+  static const uint8_t REG_WAVE_CONTROL = 0x11;
+  static const uint8_t REG_WAVE_INDEX = 0x14;
+  static const uint8_t REG_WAVE_DATA = 0x15;
+  static const uint8_t REG_STROKE_OPEN = 0x1E;
+  static const uint8_t CONTROL_CLEAR_TRIP = 1 << 2;
+
+  bool commanded = false; // last value passed to set
+  bool has_commanded = false;
+  bool trip_reported = false; // the board's current trip latch has already been pushed as an error
+
   virtual bool get_power(bool value __unused) {
     return true;
   }
@@ -27,32 +140,53 @@ class I2C: public Actuator {
   }
 public:
   I2C(uint8_t slave_address):
-    slave_address{slave_address} {}
+    RegisterDevice(slave_address) {}
 
   void set(bool value) {
-    Wire.beginTransmission(slave_address);
     // Relay boards have two relays. One turns on power, and the other selects which direction to apply power to.
     // LSB is power, next bit is select.
-    bool power = get_power(value);
-    bool select = get_select(value);
-    bool healthy = true;
-    healthy &= Wire.write((select << 1) | power) == 1; // returns the number of bytes written, should be 1
-    healthy &= Wire.endTransmission() == 0; // returns non-zero value if there was an error
-    healthy &= !Wire.getWireTimeoutFlag(); // make sure timeout flag is not set
-    if (!healthy) {
-      errors::push(slave_address, ErrorCode::I2CWriteError);
+    // A change of command clears an overcurrent trip, so the operator recovers by commanding
+    // the actuator again. Read the status first so a trip is reported before it's wiped.
+    uint8_t control = (get_select(value) << 1) | get_power(value);
+    if (has_commanded && value != commanded) {
+      uint8_t status;
+      if (read_registers(REG_STATUS, &status, 1)) {
+        check_trip(status);
+      }
+      control |= CONTROL_CLEAR_TRIP;
+    }
+    if (write_register(REG_CONTROL, control)) {
+      commanded = value;
+      has_commanded = true;
+    }
+  }
+
+  // Pushes an error once each time the board latches an overcurrent trip. It keeps power off
+  // until set() is called with a different value.
+  void check_trip(uint8_t status) {
+    if (!(status & 0b1100)) {
+      trip_reported = false;
+    } else if (!trip_reported) {
+      errors::push(slave_address, ErrorCode::OvercurrentTrip);
+      trip_reported = true;
+    }
+  }
+
+  // For boards without limit switches, where get_state has nothing else to say
+  void poll_trip() {
+    uint8_t status;
+    if (read_registers(REG_STATUS, &status, 1)) {
+      check_trip(status);
     }
-    Wire.clearWireTimeoutFlag(); // if the flag was set, clear it for next time
   }
 
   ActuatorPosition::ActuatorPosition get_state() {
-    // Cast to uint8_t to avoid warning about ambiguous overload
-    uint8_t received = Wire.requestFrom(slave_address, static_cast<uint8_t>(1)); // returns number of bytes receieved
-    if (received != 1) {
-      errors::push(slave_address, ErrorCode::I2CReadError);
+    uint8_t status;
+    if (!read_registers(REG_STATUS, &status, 1)) {
       return ActuatorPosition::error;
     }
-    uint8_t lims = Wire.read(); // first byte returned is the limit switch values
+    check_trip(status);
+    uint8_t lims = status & 0b11; // limit switch values
     if (lims == 0) return ActuatorPosition::unknown;
     if (lims == 1) return ActuatorPosition::open;
     if (lims == 2) return ActuatorPosition::closed;
@@ -63,19 +197,59 @@ public:
     if (channel > 1) { // Index must be 0 or 1 for primary or secondary
       return SENSOR_ERR_VAL;
     }
-    // Cast to uint8_t to avoid warning about ambiguous overload
-    uint8_t received = Wire.requestFrom(slave_address, static_cast<uint8_t>(5)); // returns number of bytes received
-    if (received != 5) {
-      errors::push(slave_address, ErrorCode::I2CReadError);
+    // The two 16-bit current registers are adjacent, primary first
+    uint8_t raw[2];
+    if (!read_registers(REG_CURR_SENSE_1 + 2 * channel, raw, 2)) {
       return SENSOR_ERR_VAL;
     }
-    Wire.read(); // limit switch values, ignore
-    if (channel == 1) { // if we want the secondary current
-      Wire.read(); Wire.read(); // ignore the first (primary) current value (2 bytes)
+    return CurrentMa::apply(to_u16(raw));
+  }
+
+  StrokeTimes get_stroke_times() {
+    uint8_t raw[4]; // open then close, the board reports 0xFFFF for strokes it hasn't seen
+    if (!read_registers(REG_STROKE_OPEN, raw, sizeof(raw))) {
+      return StrokeTimes{.open_ms = SENSOR_ERR_VAL, .close_ms = SENSOR_ERR_VAL};
     }
-    uint16_t adcl = Wire.read(); // get the 16-bit current reading
-    uint16_t adch = Wire.read();
-    return ((adch << 8) | adcl) * 4; // adc / 1024 (10bit) * 4096mV (vref) / 10mohm / 100 adc scaler * 1000 mV/V
+    return StrokeTimes{.open_ms = to_u16(raw), .close_ms = to_u16(raw + 2)};
+  }
+
+  // Waveform capture layout, must match src/relay_pic/waveform.h
+  static const uint8_t WAVE_NUM_SAMPLES = 64;
+  static const uint8_t WAVE_PRETRIGGER_SAMPLES = 16;
+  static const uint8_t WAVE_CHUNK_SIZE = 8;
+  static const uint16_t WAVE_SAMPLE_PERIOD_US = 200; // each channel is converted every 200us
+  typedef scale::Scale<255, 16, 1> WaveSampleMa; // samples are the top 8 bits of get_current_ma's reading
+
+  bool get_waveform_status(WaveformStatus *status) {
+    uint8_t raw[3]; // control, length and decimation are contiguous
+    if (!read_registers(REG_WAVE_CONTROL, raw, sizeof(raw))) {
+      return false;
+    }
+    status->done = raw[0] & 1;
+    status->channel = (raw[0] >> 1) & 1;
+    status->length = raw[1];
+    status->decimation = raw[2];
+    return true;
+  }
+
+  // Reads WAVE_CHUNK_SIZE samples of a finished capture starting at index. Returns the index
+  // the board actually served, which lags behind for a moment after the index changes, or
+  // 0xFF if there is no finished capture to read.
+  uint8_t read_waveform_chunk(uint8_t index, uint8_t *dest) {
+    if (!write_register(REG_WAVE_INDEX, index)) {
+      return 0xFF;
+    }
+    uint8_t raw[1 + WAVE_CHUNK_SIZE];
+    if (!read_registers(REG_WAVE_DATA, raw, sizeof(raw))) {
+      return 0xFF;
+    }
+    memcpy(dest, raw + 1, WAVE_CHUNK_SIZE);
+    return raw[0];
+  }
+
+  // Drops the current capture and waits for the next power on
+  void arm_waveform(uint8_t channel) {
+    write_register(REG_WAVE_CONTROL, (channel << 1) | 1);
   }
 };
 
@@ -90,105 +264,164 @@ public:
   Ignition(uint8_t slave_address): I2C(slave_address) {}
 };
 
-class Heater {
-  uint8_t slave_address; // slave address we are controlling
-  bool power_set;
+// All channels of a heater board, already scaled to the units of the individual getters.
+// The heater board oversamples and filters these, so they are 12 bit readings.
+struct HeaterReadings {
+  uint16_t thermistor;
+  uint16_t temperature_dk;
+  uint16_t current_ma;
+  uint16_t batt_mv;
+  uint16_t kelvin_low_mv;
+  uint16_t kelvin_high_mv;
+};
+
+class Heater: public RegisterDevice {
+  // adc / 4096 (12bit) * 4096mV (vref) / 1mohm / 100 adc scaler * 1000 mV/V
+  typedef scale::Scale<4095, 10, 1> CurrentMa;
+  // adc / 4096 (12bit) * 4096mV (vref) * 7.04 divider
+  typedef scale::Scale<4095, 176, 25> VoltageMv;
+
+  // Register map, must match src/tank_heating_relay/i2c.h
+  static const uint8_t REG_THERMISTOR = 0x00;
+  static const uint8_t REG_CURR_SENSE = 0x02;
+  static const uint8_t REG_24V_SENSE = 0x04;
+  static const uint8_t REG_KELVIN_N = 0x06;
+  static const uint8_t REG_KELVIN_P = 0x08;
+  static const uint8_t REG_CONTROL = 0x0A;
+  static const uint8_t REG_SETPOINT = 0x23; // followed by hysteresis, current limit and kelvin limit
+  static const uint8_t REG_DUTY = 0x2B;
+  static const uint8_t CONTROL_THERMOSTAT = 1 << 1;
+  static const uint8_t CONTROL_CLEAR_TRIP = 1 << 2; // write only
+  static const uint8_t CONTROL_LIMIT_TRIPPED = 1 << 3; // read only
+
+  // The board forgets its settings if it resets, so they are sent again every so often
+  static const unsigned long THERMOSTAT_REFRESH_MS = 1000;
+
+  uint16_t setpoint;
+  uint16_t hysteresis;
+  uint16_t current_limit; // raw current sense reading
+  uint16_t kelvin_limit; // raw kelvin P minus kelvin N reading
+  bool thermostat;
+  bool thermostat_sent = false;
+  unsigned long thermostat_sent_time = 0;
+  bool commanded = false; // last value passed to set
+  bool has_commanded = false;
+  bool trip_reported = false; // the board's current limit trip has already been pushed as an error
+
+  uint16_t read_channel(uint8_t reg) {
+    uint8_t raw[2];
+    if (!read_registers(reg, raw, 2)) {
+      return SENSOR_ERR_VAL;
+    }
+    return to_u16(raw);
+  }
 
 public:
 
-  Heater(uint8_t slave_address):
-      slave_address{slave_address},power_set{0} {}
+  // setpoint and hysteresis are raw 12 bit thermistor readings, which fall as the tank warms.
+  // The board turns the heater off and keeps it off if it draws more than current_limit_ma or
+  // drops more than kelvin_limit_mv across its kelvin sense. With thermostat, set(true) only
+  // allows heating and the board switches the heater around the setpoint; without, set(true)
+  // turns the heater straight on.
+  Heater(uint8_t slave_address, uint16_t setpoint, uint16_t hysteresis, uint16_t current_limit_ma,
+         uint16_t kelvin_limit_mv, bool thermostat):
+      RegisterDevice(slave_address), setpoint{setpoint}, hysteresis{hysteresis},
+      current_limit{static_cast<uint16_t>(current_limit_ma / 10)}, // inverse of CurrentMa
+      kelvin_limit{static_cast<uint16_t>(static_cast<uint32_t>(kelvin_limit_mv) * 25 / 176)}, // of VoltageMv
+      thermostat{thermostat} {}
 
   void set(bool value) {
-    power_set = value;
-    Wire.beginTransmission(slave_address);
-    // LSB is power, bit [3:1] are for register select
-    bool healthy = true;
-    healthy &= Wire.write(power_set) == 1; // returns the number of bytes written, should be 1
-    healthy &= Wire.endTransmission() == 0; // returns non-zero value if there was an error
-    healthy &= !Wire.getWireTimeoutFlag(); // make sure timeout flag is not set
-    if (!healthy) {
-      errors::push(slave_address, ErrorCode::I2CWriteError);
+    if (!thermostat_sent || millis() - thermostat_sent_time >= THERMOSTAT_REFRESH_MS) {
+      uint8_t raw[8]; // setpoint, hysteresis, current limit then kelvin limit
+      from_u16(setpoint, raw);
+      from_u16(hysteresis, raw + 2);
+      from_u16(current_limit, raw + 4);
+      from_u16(kelvin_limit, raw + 6);
+      thermostat_sent = write_registers(REG_SETPOINT, raw, sizeof(raw));
+      thermostat_sent_time = millis();
+    }
+    // LSB allows heating, next bit lets the board's thermostat switch the heater around the
+    // setpoint. A change of command clears a tripped limit, after reporting it.
+    uint8_t control = (thermostat ? CONTROL_THERMOSTAT : 0) | value;
+    if (has_commanded && value != commanded) {
+      poll_trip();
+      control |= CONTROL_CLEAR_TRIP;
+    }
+    if (write_register(REG_CONTROL, control)) {
+      commanded = value;
+      has_commanded = true;
     }
-    Wire.clearWireTimeoutFlag(); // if the flag was set, clear it for next time
   }
 
-  void select_reg(uint8_t reg){
-    Wire.beginTransmission(slave_address);
-    // LSB is power, bit [3:1] are for register select
-    bool healthy = true;
-    healthy &= Wire.write(power_set | (reg << 1)) == 1; // returns the number of bytes written, should be 1
-    healthy &= Wire.endTransmission() == 0; // returns non-zero value if there was an error
-    healthy &= !Wire.getWireTimeoutFlag(); // make sure timeout flag is not set
-    if (!healthy) {
-      errors::push(slave_address, ErrorCode::I2CWriteError);
+  // Pushes an error once each time the board trips on a safety limit
+  void poll_trip() {
+    uint8_t control;
+    if (!read_registers(REG_CONTROL, &control, 1)) {
+      return;
+    }
+    if (!(control & CONTROL_LIMIT_TRIPPED)) {
+      trip_reported = false;
+    } else if (!trip_reported) {
+      errors::push(slave_address, ErrorCode::HeaterLimitTrip);
+      trip_reported = true;
     }
-    Wire.clearWireTimeoutFlag(); // if the flag was set, clear it for next time
   }
 
-  uint16_t get_thermistor() {
-    select_reg(0);
-    // Cast to uint8_t to avoid warning about ambiguous overload
-    uint8_t received = Wire.requestFrom(slave_address, static_cast<uint8_t>(2)); // returns number of bytes received
-    if (received != 2) {
-      errors::push(slave_address, ErrorCode::I2CReadError);
-      return SENSOR_ERR_VAL;
+  // Percent of the last 10s the heater was on
+  uint8_t get_duty() {
+    uint8_t duty;
+    if (!read_registers(REG_DUTY, &duty, 1)) {
+      return 0xFF;
     }
-    uint16_t adcl = Wire.read();
-    uint16_t adch = Wire.read();
-    return ((adch << 8) | adcl); // Return raw ADC values
+    return duty;
+  }
+
+  uint16_t get_thermistor() {
+    return read_channel(REG_THERMISTOR); // Return raw 12 bit ADC values
+  }
+
+  uint16_t get_temperature_dk() {
+    return thermistor::to_deci_kelvin(get_thermistor()); // passes SENSOR_ERR_VAL through
   }
 
   uint16_t get_current_ma() {
-    select_reg(1);
-    // Cast to uint8_t to avoid warning about ambiguous overload
-    uint8_t received = Wire.requestFrom(slave_address, static_cast<uint8_t>(2)); // returns number of bytes received
-    if (received != 2) {
-      errors::push(slave_address, ErrorCode::I2CReadError);
-      return SENSOR_ERR_VAL;
-    }
-    uint16_t adcl = Wire.read();
-    uint16_t adch = Wire.read();
-    return ((adch << 8) | adcl) * 40; // adc / 1024 (10bit) * 4096mV (vref) / 1mohm / 100 adc scaler * 1000 mV/V
+    return CurrentMa::apply_or_err(read_channel(REG_CURR_SENSE));
   }
 
   uint16_t get_batt_voltage() {
-    select_reg(2);
-    // Cast to uint8_t to avoid warning about ambiguous overload
-    uint8_t received = Wire.requestFrom(slave_address, static_cast<uint8_t>(2)); // returns number of bytes received
-    if (received != 2) {
-      errors::push(slave_address, ErrorCode::I2CReadError);
-      return SENSOR_ERR_VAL;
-    }
-    uint16_t adcl = Wire.read();
-    uint16_t adch = Wire.read();
-    return ((adch << 8) | adcl) * 28; // adc / 1024 (10bit) * 4096mV (vref) * 7.04
+    return VoltageMv::apply_or_err(read_channel(REG_24V_SENSE));
   }
 
   uint16_t get_kelvin_low_voltage() {
-    select_reg(3);
-    // Cast to uint8_t to avoid warning about ambiguous overload
-    uint8_t received = Wire.requestFrom(slave_address, static_cast<uint8_t>(2)); // returns number of bytes received
-    if (received != 2) {
-      errors::push(slave_address, ErrorCode::I2CReadError);
-      return SENSOR_ERR_VAL;
-    }
-    uint16_t adcl = Wire.read();
-    uint16_t adch = Wire.read();
-    return ((adch << 8) | adcl) * 28; // adc / 1024 (10bit) * 4096mV (vref) * 7.04
+    return VoltageMv::apply_or_err(read_channel(REG_KELVIN_N));
   }
 
   uint16_t get_kelvin_high_voltage() {
-    select_reg(4);
-    // Cast to uint8_t to avoid warning about ambiguous overload
-    uint8_t received = Wire.requestFrom(slave_address, static_cast<uint8_t>(2)); // returns number of bytes received
-    if (received != 2) {
-      errors::push(slave_address, ErrorCode::I2CReadError);
-      return SENSOR_ERR_VAL;
+    return VoltageMv::apply_or_err(read_channel(REG_KELVIN_P));
+  }
+
+  // Reads every channel in one burst. Prefer this over the individual getters when polling
+  // everything, since the analog registers are contiguous and it costs a single read.
+  HeaterReadings get_readings() {
+    uint8_t raw[10];
+    if (!read_registers(REG_THERMISTOR, raw, sizeof(raw))) {
+      return HeaterReadings{
+          .thermistor = SENSOR_ERR_VAL,
+          .temperature_dk = SENSOR_ERR_VAL,
+          .current_ma = SENSOR_ERR_VAL,
+          .batt_mv = SENSOR_ERR_VAL,
+          .kelvin_low_mv = SENSOR_ERR_VAL,
+          .kelvin_high_mv = SENSOR_ERR_VAL,
+      };
     }
-    uint16_t adcl = Wire.read();
-    uint16_t adch = Wire.read();
-    return ((adch << 8) | adcl) * 28; // adc / 1024 (10bit) * 4096mV (vref) * 7.04
+    return HeaterReadings{
+        .thermistor = to_u16(raw + REG_THERMISTOR),
+        .temperature_dk = thermistor::to_deci_kelvin(to_u16(raw + REG_THERMISTOR)),
+        .current_ma = CurrentMa::apply(to_u16(raw + REG_CURR_SENSE)),
+        .batt_mv = VoltageMv::apply(to_u16(raw + REG_24V_SENSE)),
+        .kelvin_low_mv = VoltageMv::apply(to_u16(raw + REG_KELVIN_N)),
+        .kelvin_high_mv = VoltageMv::apply(to_u16(raw + REG_KELVIN_P)),
+    };
   }
 };
 
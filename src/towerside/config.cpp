@@ -1,7 +1,9 @@
 #include "actuators.hpp"
 #include "config.hpp"
 #include "errors.hpp"
+#include "failsafe.hpp"
 #include "sensors.hpp"
+#include "waveform.hpp"
 
 namespace config {
 
@@ -12,44 +14,84 @@ struct Actuators {
   actuator::I2C injector_value{4};
   actuator::Ignition ignition_primary{6};
   actuator::Ignition ignition_secondary{7};
-  actuator::Heater heater_1{16};
-  actuator::Heater heater_2{17};
+  actuator::Heater heater_1{16, HEATER_SETPOINT, HEATER_HYSTERESIS, HEATER_CURRENT_LIMIT_MA, HEATER_KELVIN_LIMIT_MV,
+                            HEATER_THERMOSTAT};
+  actuator::Heater heater_2{17, HEATER_SETPOINT, HEATER_HYSTERESIS, HEATER_CURRENT_LIMIT_MA, HEATER_KELVIN_LIMIT_MV,
+                            HEATER_THERMOSTAT};
 } ACTUATORS;
 
 void apply(const ActuatorMessage &command) {
-  ACTUATORS.ov101.set(command.ov101);
-  ACTUATORS.ov102.set(command.ov102);
-  ACTUATORS.ov103.set(command.ov103);
-  ACTUATORS.injector_value.set(command.injector_valve);
-  ACTUATORS.ignition_primary.set(command.ignition_primary);
-  ACTUATORS.ignition_secondary.set(command.ignition_primary); // fire both ignitions in response to ignition_primary
-  ACTUATORS.heater_1.set(command.tank_heating_1);
-  ACTUATORS.heater_2.set(command.tank_heating_2);
+  // Each I2C write can take a few ms, so the failsafe is checked before every one of them
+  const ActuatorMessage safe = build_safe_state(command);
+  auto cmd = [&]() -> const ActuatorMessage & {
+    return failsafe::tripped() ? safe : command;
+  };
+  ACTUATORS.ov101.set(cmd().ov101);
+  ACTUATORS.ov102.set(cmd().ov102);
+  ACTUATORS.ov103.set(cmd().ov103);
+  ACTUATORS.injector_value.set(cmd().injector_valve);
+  ACTUATORS.ignition_primary.set(cmd().ignition_primary);
+  ACTUATORS.ignition_secondary.set(cmd().ignition_primary); // fire both ignitions in response to ignition_primary
+  ACTUATORS.heater_1.set(cmd().tank_heating_1);
+  ACTUATORS.heater_2.set(cmd().tank_heating_2);
 }
 
 SensorMessage build_sensor_message() {
+  sensors::BattReading main_batt = sensors::read_main_batt();
+  sensors::BattReading actuator_batt = sensors::read_actuator_batt();
+  actuator::HeaterReadings heater_1 = ACTUATORS.heater_1.get_readings();
+  actuator::HeaterReadings heater_2 = ACTUATORS.heater_2.get_readings();
+  actuator::StrokeTimes ov101_stroke = ACTUATORS.ov101.get_stroke_times();
+  actuator::StrokeTimes ov102_stroke = ACTUATORS.ov102.get_stroke_times();
+  actuator::StrokeTimes ov103_stroke = ACTUATORS.ov103.get_stroke_times();
+  ACTUATORS.ignition_primary.poll_trip();
+  ACTUATORS.ignition_secondary.poll_trip();
+  ACTUATORS.heater_1.poll_trip();
+  ACTUATORS.heater_2.poll_trip();
   return SensorMessage{
-      .towerside_main_batt_mv = sensors::get_main_batt_mv(),
-      .towerside_actuator_batt_mv = sensors::get_actuator_batt_mv(),
-      .error_code = errors::pop(),
+      .towerside_main_batt_mv = main_batt.mv,
+      .towerside_actuator_batt_mv = actuator_batt.mv,
+      .towerside_main_batt_min_mv = main_batt.min_mv,
+      .towerside_main_batt_max_mv = main_batt.max_mv,
+      .towerside_actuator_batt_min_mv = actuator_batt.min_mv,
+      .towerside_actuator_batt_max_mv = actuator_batt.max_mv,
+      .errors = errors::take_summary(),
       .towerside_armed = sensors::is_armed(),
       .has_contact = sensors::has_contact(),
+      .failsafe_latency_ms = failsafe::get_latency_ms(),
       .ignition_primary_ma = ACTUATORS.ignition_primary.get_current_ma(1),
       .ignition_secondary_ma = ACTUATORS.ignition_secondary.get_current_ma(1),
       .ov101_state = ACTUATORS.ov101.get_state(),
       .ov102_state = ACTUATORS.ov102.get_state(),
       .ov103_state = ACTUATORS.ov103.get_state(),
-      .heater_thermistor_1 = ACTUATORS.heater_1.get_thermistor(),
-      .heater_thermistor_2 = ACTUATORS.heater_2.get_thermistor(),
-      .heater_current_ma_1 = ACTUATORS.heater_1.get_current_ma(),
-      .heater_current_ma_2 = ACTUATORS.heater_2.get_current_ma(),
-      .heater_batt_mv_1 = ACTUATORS.heater_1.get_batt_voltage(),
-      .heater_batt_mv_2 = ACTUATORS.heater_2.get_batt_voltage(),
-      .heater_kelvin_low_mv_1 = ACTUATORS.heater_1.get_kelvin_low_voltage(),
-      .heater_kelvin_low_mv_2 = ACTUATORS.heater_2.get_kelvin_low_voltage(),
-      .heater_kelvin_high_mv_1 = ACTUATORS.heater_1.get_kelvin_high_voltage(),
-      .heater_kelvin_high_mv_2 = ACTUATORS.heater_2.get_kelvin_high_voltage()
+      .ov101_open_ms = ov101_stroke.open_ms,
+      .ov101_close_ms = ov101_stroke.close_ms,
+      .ov102_open_ms = ov102_stroke.open_ms,
+      .ov102_close_ms = ov102_stroke.close_ms,
+      .ov103_open_ms = ov103_stroke.open_ms,
+      .ov103_close_ms = ov103_stroke.close_ms,
+      .heater_temp_dk_1 = heater_1.temperature_dk,
+      .heater_temp_dk_2 = heater_2.temperature_dk,
+      .heater_current_ma_1 = heater_1.current_ma,
+      .heater_current_ma_2 = heater_2.current_ma,
+      .heater_batt_mv_1 = heater_1.batt_mv,
+      .heater_batt_mv_2 = heater_2.batt_mv,
+      .heater_kelvin_low_mv_1 = heater_1.kelvin_low_mv,
+      .heater_kelvin_low_mv_2 = heater_2.kelvin_low_mv,
+      .heater_kelvin_high_mv_1 = heater_1.kelvin_high_mv,
+      .heater_kelvin_high_mv_2 = heater_2.kelvin_high_mv,
+      .heater_duty_1 = ACTUATORS.heater_1.get_duty(),
+      .heater_duty_2 = ACTUATORS.heater_2.get_duty()
   };
 }
 
+void stream_waveforms() {
+  static waveform::Reader reader;
+  static bool secondary = false;
+  actuator::I2C &board = secondary ? ACTUATORS.ignition_secondary : ACTUATORS.ignition_primary;
+  if (reader.tick(board)) {
+    secondary = !secondary;
+  }
+}
+
 } // namespace config
@@ -4,15 +4,42 @@
 #include <stdint.h>
 
 #include "common/config.hpp"
+#include "thermistor.hpp"
 
 namespace config {
 
+// Commands every actuator. If the failsafe trips partway through, the remaining actuators get
+// the safe state instead.
 void apply(const ActuatorMessage &command);
 SensorMessage build_sensor_message();
 
-constexpr uint16_t COMMUNICATION_TIMEOUT_S = 10; // Go to safe state after this many seconds without contact
+// Reads out ignition current captures a piece at a time, call it periodically
+void stream_waveforms();
+
+constexpr unsigned long COMMUNICATION_TIMEOUT_MS = 10000; // Go to safe state after this long without a valid message
 constexpr unsigned long SENSOR_MSG_INTERVAL_MS = 100; // Rate to send sensor messages at
+constexpr unsigned long RADIO_BAUD = 9600; // Serial2, the radio link to clientside
 constexpr unsigned long COMMUNICATION_RESET_MS = 50; // maximum time between successive characters in the same message
+constexpr uint16_t HEATER_SETPOINT_DK = 3032; // Tank temperature the heaters hold, deci-Kelvin
+constexpr uint16_t HEATER_HYSTERESIS_DK = 10; // Heaters come on once the tank is this much colder
+// The heater boards cut power and report HeaterLimitTrip past these until the command changes
+constexpr uint16_t HEATER_CURRENT_LIMIT_MA = 10000;
+constexpr uint16_t HEATER_KELVIN_LIMIT_MV = 26000;
+// With the thermostat, the heating switches only allow heating and the boards hold the tank at
+// HEATER_SETPOINT_DK. Without, they turn the heaters straight on and off.
+constexpr bool HEATER_THERMOSTAT = true;
+// The heater boards work in raw thermistor readings, which fall as the tank warms
+constexpr uint16_t HEATER_SETPOINT = thermistor::raw_at_deci_kelvin(HEATER_SETPOINT_DK);
+constexpr uint16_t HEATER_HYSTERESIS =
+    thermistor::raw_at_deci_kelvin(HEATER_SETPOINT_DK - HEATER_HYSTERESIS_DK) - HEATER_SETPOINT;
+
+// Link budget: at 8N1 the radio moves RADIO_BAUD / 10 bytes/s, and every sensor message goes
+// out framed as 'W', the struct, 'R', '\n'. At 76 bytes that's 790 of 960 bytes/s, about 82%.
+// Much closer to 100% and a message is still draining when the next one is sent, so send()
+// blocks the main loop on the full transmit buffer. Send slow-changing fields (stroke times,
+// min/max windows, duty) less often rather than growing the message past this.
+static_assert((sizeof(SensorMessage) + 3) * (1000 / SENSOR_MSG_INTERVAL_MS) <= RADIO_BAUD / 10 * 85 / 100,
+              "sensor messages no longer fit the radio link budget");
 
 } // namespace config
 
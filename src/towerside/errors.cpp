@@ -1,38 +1,95 @@
 #include "errors.hpp"
 
+#include "common/mock_arduino.hpp"
+
 namespace errors {
 
-#define BUF_SIZE 10
-uint16_t errors[BUF_SIZE]; // ringbuffer of errors
-uint8_t err_index = 0; // index of oldest error stored
-uint8_t err_len = 0; // number of stored errors
-// In order to make sure we show all the errors we see,
-// if the buffer overflows we completely drain it before
-// allowing new errors to be added.
-bool full = false; // whether we are draining the buffer
+namespace {
+
+struct Entry {
+  uint8_t device;
+  uint8_t code;
+  uint16_t count; // 0 while the entry is unused
+  uint16_t reported_count;
+  unsigned long first_ms;
+  unsigned long last_ms;
+};
+
+// Every actuator board with each of its error codes would be 24, but in practice only a few
+// ever show up at once. Errors that don't fit are only counted in overflow_count.
+constexpr uint8_t TABLE_SIZE = 12;
+Entry table[TABLE_SIZE];
+uint8_t next_report = 0; // where the next summary starts looking
+uint16_t overflow_count = 0;
+uint16_t reported_overflow_count = 0;
+
+// Entries are never freed, so the used ones are all at the start and the first unused one
+// means there is no match
+Entry *find(uint8_t id, uint8_t code) {
+  for (uint8_t i = 0; i < TABLE_SIZE; i++) {
+    if (table[i].count == 0 || (table[i].device == id && table[i].code == code)) {
+      return &table[i];
+    }
+  }
+  return nullptr;
+}
+
+uint16_t saturating_increment(uint16_t count) {
+  return count == 0xFFFF ? count : count + 1;
+}
+
+ErrorReport report(uint8_t device, uint8_t code, uint16_t count, unsigned long active_ms) {
+  unsigned long active_s = active_ms / 1000;
+  return ErrorReport{
+      .device = device,
+      .code = static_cast<ErrorCode::ErrorCode>(code),
+      .count = count,
+      .active_s = static_cast<uint16_t>(active_s > 0xFFFF ? 0xFFFF : active_s),
+  };
+}
+
+} // namespace
 
 void push(uint8_t id, uint8_t code) {
-  if (full) {
+  Entry *entry = find(id, code);
+  if (entry == nullptr) {
+    overflow_count = saturating_increment(overflow_count);
     return;
   }
-  errors[(err_index + err_len) % BUF_SIZE] = (static_cast<uint16_t>(id) << 8) | code;
-  err_len++;
-  if (err_len == BUF_SIZE) {
-    full = true;
+  unsigned long now = millis();
+  if (entry->count == 0) {
+    entry->device = id;
+    entry->code = code;
+    entry->first_ms = now;
   }
+  entry->count = saturating_increment(entry->count);
+  entry->last_ms = now;
 }
 
-uint16_t pop() {
-  if (err_len == 0) {
-    return 0;
+ErrorSummary take_summary() {
+  ErrorSummary summary = {};
+  uint8_t filled = 0;
+  if (overflow_count != reported_overflow_count) {
+    summary.reports[filled++] = report(0, ErrorCode::ErrorTableFull, overflow_count, 0);
+    reported_overflow_count = overflow_count;
   }
-  uint16_t res = errors[err_index];
-  err_index = (err_index + 1) % BUF_SIZE;
-  err_len--;
-  if (err_len == 0) {
-    full = false;
+
+  uint8_t i = next_report;
+  for (uint8_t checked = 0; checked < TABLE_SIZE; checked++) {
+    Entry &entry = table[i];
+    i = i + 1 == TABLE_SIZE ? 0 : i + 1;
+    if (entry.count == entry.reported_count) {
+      continue;
+    }
+    if (filled == ERROR_REPORTS_PER_MESSAGE) {
+      summary.pending++;
+      continue;
+    }
+    summary.reports[filled++] = report(entry.device, entry.code, entry.count, entry.last_ms - entry.first_ms);
+    entry.reported_count = entry.count;
+    next_report = i;
   }
-  return res;
+  return summary;
 }
 
 } // namespace errors
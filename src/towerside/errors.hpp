@@ -3,10 +3,18 @@
 
 #include <stdint.h>
 
+#include "common/config.hpp"
+
+// Error counters per (device, error code). Repeats of the same error only bump its counter, so
+// a failing board can't crowd out the others, and each telemetry message carries the errors
+// that changed since the previous one.
 namespace errors {
 
 void push(uint8_t id, uint8_t code);
-uint16_t pop();
+
+// Errors whose count changed since they were last taken. Takes turns through the table when
+// more changed than fit, so every one of them gets reported.
+ErrorSummary take_summary();
 
 } // namespace errors
 
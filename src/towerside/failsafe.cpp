@@ -0,0 +1,109 @@
+#include "failsafe.hpp"
+
+#include "common/mock_arduino.hpp"
+#include "config.hpp"
+
+namespace failsafe {
+
+namespace {
+
+// Shared with the timer interrupt, only touched with interrupts masked outside of it
+volatile unsigned long last_frame_ms = 0;
+volatile bool is_tripped = false;
+volatile uint8_t trip_count = 0;
+uint8_t measured_trip_count = 0; // main loop only
+uint16_t latency_ms = 0;
+
+void check() {
+  if (!is_tripped && millis() - last_frame_ms >= config::COMMUNICATION_TIMEOUT_MS) {
+    is_tripped = true;
+    trip_count++;
+  }
+}
+
+} // namespace
+
+#ifdef ARDUINO
+
+void handle_timer_interrupt() {
+  check();
+}
+
+void setup() {
+  // Timer3 in CTC mode at 1 kHz: 16 MHz / 64 / 250
+  TCCR3A = 0;
+  TCCR3B = (1 << WGM32) | (1 << CS31) | (1 << CS30);
+  OCR3A = 249;
+  TIMSK3 = (1 << OCIE3A);
+}
+
+void frame_received() {
+  uint8_t sreg = SREG;
+  cli();
+  last_frame_ms = millis();
+  is_tripped = false;
+  SREG = sreg;
+}
+
+bool tripped() {
+  return is_tripped;
+}
+
+namespace {
+
+unsigned long get_last_frame_ms() {
+  uint8_t sreg = SREG;
+  cli();
+  unsigned long ms = last_frame_ms;
+  SREG = sreg;
+  return ms;
+}
+
+} // namespace
+
+#else
+
+// No timer interrupt on the host, check whenever someone asks
+void setup() {}
+
+void frame_received() {
+  last_frame_ms = millis();
+  is_tripped = false;
+}
+
+bool tripped() {
+  check();
+  return is_tripped;
+}
+
+namespace {
+
+unsigned long get_last_frame_ms() {
+  return last_frame_ms;
+}
+
+} // namespace
+
+#endif
+
+void safe_state_applied() {
+  // Only the first full pass after each trip counts
+  if (measured_trip_count == trip_count) {
+    return;
+  }
+  measured_trip_count = trip_count;
+  unsigned long latency = millis() - (get_last_frame_ms() + config::COMMUNICATION_TIMEOUT_MS);
+  latency_ms = latency > 0xFFFF ? 0xFFFF : latency;
+}
+
+uint16_t get_latency_ms() {
+  return latency_ms;
+}
+
+} // namespace failsafe
+
+#ifdef ARDUINO
+ISR(TIMER3_COMPA_vect) {
+  failsafe::handle_timer_interrupt();
+}
+#endif
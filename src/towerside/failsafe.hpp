@@ -0,0 +1,28 @@
+#ifndef FAILSAFE_H
+#define FAILSAFE_H
+
+#include <stdint.h>
+
+// Loss of contact detection that doesn't depend on the main loop. A timer interrupt checks
+// the time since the last valid frame every millisecond and latches a trip once it passes
+// config::COMMUNICATION_TIMEOUT_MS. The main loop (and config::apply between actuators) then
+// only has to look at the latch, so a loop stalled on I2C still reacts within one transaction.
+namespace failsafe {
+
+void setup();
+
+// Call whenever a valid frame arrives from clientside, clears the trip
+void frame_received();
+
+// Whether we have gone COMMUNICATION_TIMEOUT_MS without a valid frame
+bool tripped();
+
+// Call when the safe state has been commanded to every actuator because of a trip
+void safe_state_applied();
+
+// Time from the timeout passing to the safe state being applied, for the most recent trip
+uint16_t get_latency_ms();
+
+} // namespace failsafe
+
+#endif
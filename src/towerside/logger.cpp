@@ -0,0 +1,262 @@
+#include "logger.hpp"
+
+#include "common/log_format.hpp"
+#include "common/mock_arduino.hpp"
+#include "common/ring_buffer.hpp"
+#include "errors.hpp"
+#include "failsafe.hpp"
+#include "pinout.hpp"
+#include "sensors.hpp"
+
+namespace logger {
+
+namespace {
+
+// The card is written this much per loop pass. The SD library keeps its own 512 byte cache and
+// only talks to the card when a whole sector is in it, so most slices are just a copy.
+constexpr uint16_t SLICE_SIZE = 128;
+// How often the file's size in the directory is brought up to date, which is all that is lost
+// if power goes out
+constexpr unsigned long SYNC_INTERVAL_MS = 1000;
+
+struct Block {
+  log_format::BlockHeader header;
+  uint8_t data[log_format::BLOCK_DATA_SIZE];
+};
+static_assert(sizeof(Block) == log_format::BLOCK_SIZE, "blocks have to match the card's sectors");
+
+struct StatusSample {
+  uint32_t time_ms;
+  log_format::StatusRecord record;
+};
+
+// The interrupt fills samples and the main loop drains them, which gives the loop 160ms to come
+// around before samples are lost
+RingBuffer<StatusSample, 16> samples;
+volatile uint16_t dropped_samples = 0; // written from the interrupt, read with it masked
+
+// Double buffer: records go into `filling` until it's full and committed, while the oldest
+// committed block is written out to the card
+RingBuffer<Block, 2> blocks;
+Block *filling = nullptr;
+uint16_t written = 0; // bytes of the oldest committed block already handed to the card
+uint32_t next_sequence = 0;
+uint16_t dropped_records = 0;
+
+File file;
+bool active = false;
+unsigned long last_sync_ms = 0;
+ActuatorMessage last_command;
+bool command_logged = false;
+
+uint16_t saturating_add(uint16_t a, uint16_t b) {
+  return a > 0xFFFF - b ? 0xFFFF : a + b;
+}
+
+void sample_status() {
+  StatusSample sample = {
+      .time_ms = static_cast<uint32_t>(millis()),
+      .record = {
+          .main_batt_mv = sensors::get_main_batt_mv(),
+          .actuator_batt_mv = sensors::get_actuator_batt_mv(),
+          .flags = static_cast<uint8_t>((sensors::is_armed() ? log_format::STATUS_ARMED : 0) |
+                                        (sensors::has_contact() ? log_format::STATUS_CONTACT : 0) |
+                                        (failsafe::tripped() ? log_format::STATUS_FAILSAFE_TRIPPED : 0)),
+      },
+  };
+  if (!samples.push(sample)) {
+    dropped_samples = saturating_add(dropped_samples, 1);
+  }
+}
+
+void commit_block() {
+  memset(filling->data + filling->header.used, 0, sizeof(filling->data) - filling->header.used);
+  blocks.commit(1);
+  filling = nullptr;
+}
+
+void append(log_format::RecordType type, uint32_t time_ms, const void *payload, uint8_t length) {
+  uint16_t size = sizeof(log_format::RecordHeader) + length;
+  if (filling != nullptr && filling->header.used + size > sizeof(filling->data)) {
+    commit_block();
+  }
+  if (filling == nullptr) {
+    RingBuffer<Block, 2>::Span span = blocks.write_span();
+    if (span.length == 0) { // both blocks still waiting on the card
+      dropped_records = saturating_add(dropped_records, 1);
+      return;
+    }
+    filling = span.data;
+    filling->header = log_format::BlockHeader{
+        .magic = log_format::BLOCK_MAGIC,
+        .sequence = next_sequence++,
+        .used = 0,
+        .version = log_format::VERSION,
+        .records = 0,
+        .dropped = dropped_records,
+    };
+    dropped_records = 0;
+  }
+  log_format::RecordHeader header = {.type = type, .length = length, .time_ms = time_ms};
+  uint8_t *dest = filling->data + filling->header.used;
+  memcpy(dest, &header, sizeof(header));
+  memcpy(dest + sizeof(header), payload, length);
+  filling->header.used += size;
+  filling->header.records++;
+}
+
+} // namespace
+
+#ifdef ARDUINO
+
+void handle_timer_interrupt() {
+  sample_status();
+}
+
+namespace {
+
+void start_sampling() {
+  // Timer5 in CTC mode at 100 Hz: 16 MHz / 256 / 625
+  TCCR5A = 0;
+  TCCR5B = (1 << WGM52) | (1 << CS52);
+  OCR5A = 624;
+  TIMSK5 = (1 << OCIE5A);
+}
+
+void stop_sampling() {
+  TIMSK5 = 0;
+}
+
+void poll_sampling() {} // the interrupt takes care of it
+
+uint16_t take_dropped_samples() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t dropped = dropped_samples;
+  dropped_samples = 0;
+  SREG = sreg;
+  return dropped;
+}
+
+} // namespace
+
+#else
+
+// No timer interrupt on the host, sample from the main loop instead
+namespace {
+
+unsigned long last_sample_ms = 0;
+
+void start_sampling() {}
+void stop_sampling() {}
+
+void poll_sampling() {
+  if (millis() - last_sample_ms >= log_format::STATUS_INTERVAL_MS) {
+    last_sample_ms = millis();
+    sample_status();
+  }
+}
+
+uint16_t take_dropped_samples() {
+  uint16_t dropped = dropped_samples;
+  dropped_samples = 0;
+  return dropped;
+}
+
+} // namespace
+
+#endif
+
+namespace {
+
+void stop() {
+  active = false;
+  stop_sampling();
+  file.close();
+  errors::push(0, ErrorCode::LogWriteError);
+}
+
+void write_slice() {
+  RingBuffer<Block, 2>::Span span = blocks.read_span();
+  if (span.length == 0) {
+    if (millis() - last_sync_ms >= SYNC_INTERVAL_MS) {
+      last_sync_ms = millis();
+      file.flush();
+    }
+    return;
+  }
+  uint16_t size = log_format::BLOCK_SIZE - written < SLICE_SIZE ? log_format::BLOCK_SIZE - written : SLICE_SIZE;
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(span.data);
+  if (file.write(bytes + written, size) != size) {
+    stop();
+    return;
+  }
+  written += size;
+  if (written == log_format::BLOCK_SIZE) {
+    written = 0;
+    blocks.consume(1);
+  }
+}
+
+} // namespace
+
+void setup() {
+  if (!SD.begin(pinout::SD_CHIP_SELECT)) {
+    errors::push(0, ErrorCode::LogWriteError);
+    return;
+  }
+  char name[] = "LOG000.BIN";
+  for (uint16_t i = 0; i < 1000; i++) {
+    name[3] = '0' + i / 100;
+    name[4] = '0' + i / 10 % 10;
+    name[5] = '0' + i % 10;
+    if (!SD.exists(name)) {
+      file = SD.open(name, FILE_WRITE);
+      break;
+    }
+  }
+  if (!file) {
+    errors::push(0, ErrorCode::LogWriteError);
+    return;
+  }
+  active = true;
+  start_sampling();
+}
+
+void tick(const ActuatorMessage &command) {
+  if (!active) {
+    return;
+  }
+  poll_sampling();
+  dropped_records = saturating_add(dropped_records, take_dropped_samples());
+  StatusSample sample;
+  while (samples.pop(&sample)) {
+    append(log_format::RECORD_STATUS, sample.time_ms, &sample.record, sizeof(sample.record));
+  }
+  if (!command_logged || !(command == last_command)) {
+    append(log_format::RECORD_COMMAND, millis(), &command, sizeof(command));
+    last_command = command;
+    command_logged = true;
+  }
+  // The card blocks the loop while it's busy, so leave it alone while the failsafe needs the
+  // loop to hold the safe state. Records pile up in the blocks and are counted as dropped once
+  // both are full, writing picks up again when contact is back.
+  if (!failsafe::tripped()) {
+    write_slice();
+  }
+}
+
+void log_sensors(const SensorMessage &msg) {
+  if (!active) {
+    return;
+  }
+  append(log_format::RECORD_SENSORS, millis(), &msg, sizeof(msg));
+}
+
+} // namespace logger
+
+#ifdef ARDUINO
+ISR(TIMER5_COMPA_vect) {
+  logger::handle_timer_interrupt();
+}
+#endif
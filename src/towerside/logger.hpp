@@ -0,0 +1,30 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "common/config.hpp"
+
+// Binary log on the SD card, see common/log_format.hpp for the layout. Status is sampled from
+// a 100 Hz Timer5 interrupt, so the rate doesn't depend on how long I2C holds up the main loop.
+// Records are collected into one 512 byte block while the other is written out to the card a
+// slice per loop pass, so a slow card only costs records once both blocks are waiting on it.
+//
+// The card I/O itself is synchronous. Most slices are a copy into the SD library's cache, but
+// one in four writes a sector, and the once a second sync writes the sector and the directory
+// entry. Each of those waits up to the library's 600ms busy timeout, and a sector that needs a
+// new cluster also updates the FAT, so a failing card can stall one loop pass for a couple of
+// seconds. The failsafe still trips on time (see failsafe.hpp), but applying the safe state
+// waits for the pass to finish, so the card is left alone while the failsafe is tripped.
+namespace logger {
+
+// Opens the first unused LOGnnn.BIN. Without a card everything else does nothing.
+void setup();
+
+// Call every loop pass with the command being applied. Logs it when it changes, turns the
+// status samples into records and writes the next slice of a full block to the card.
+void tick(const ActuatorMessage &command);
+
+void log_sensors(const SensorMessage &msg);
+
+} // namespace logger
+
+#endif
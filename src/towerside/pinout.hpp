@@ -20,6 +20,9 @@ const uint8_t SEVENSEG_F  = 46;
 const uint8_t SEVENSEG_G  = 40;
 const uint8_t SEVENSEG_DP = 44;
 
+// SD card on the SPI header, selected with the Mega's hardware SS pin
+const uint8_t SD_CHIP_SELECT = 53;
+
 const uint8_t COMM_STATUS_LED = 35;
 const uint8_t ARM_STATUS_LED = 36;
 
@@ -1,18 +1,150 @@
 #include "sensors.hpp"
 
+#include "common/fast_pin.hpp"
 #include "common/mock_arduino.hpp"
+#include "common/scale.hpp"
 #include "pinout.hpp"
 
 namespace sensors {
 
+namespace {
+
+// The battery channels are converted round-robin from the ADC interrupt. Each channel sums
+// OVERSAMPLE_COUNT 10 bit samples into a 12 bit reading, which goes through a first order IIR
+// low pass filter, and tracks the min and max reading since it was last read.
+constexpr uint8_t OVERSAMPLE_COUNT = 16;
+constexpr uint8_t OVERSAMPLE_SHIFT = 2; // sum of OVERSAMPLE_COUNT samples >> 2 = 12 bit reading
+constexpr uint8_t IIR_SHIFT = 2; // each new reading is weighted 1 / 2^IIR_SHIFT
+constexpr uint8_t IIR_FRAC_BITS = 4; // fractional bits kept in the filter state
+
+// Scales a 12 bit reading to a voltage based on the resistor divider, about 3.5mV per count
+// (14.1mV per count of the arduino's 0-1023 analog value)
+typedef scale::Scale<4095, 60, 17> BattMv;
+
+struct AdcChannel {
+  uint8_t pin;
+  uint16_t accumulator;
+  uint8_t count;
+  bool primed;
+  uint16_t filtered; // 12 bit reading with IIR_FRAC_BITS fractional bits
+  uint16_t min; // since the last read
+  uint16_t max;
+};
+
+enum Channel : uint8_t { MAIN_BATT, ACTUATOR_BATT, NUM_CHANNELS };
+
+volatile AdcChannel channels[NUM_CHANNELS] = {
+    {pinout::MAIN_BATT_VOLTAGE, 0, 0, false, 0, 0xFFFF, 0},
+    {pinout::ACTUATOR_BATT_VOLTAGE, 0, 0, false, 0, 0xFFFF, 0},
+};
+
+void add_sample(volatile AdcChannel &channel, uint16_t sample) {
+  channel.accumulator += sample;
+  if (++channel.count < OVERSAMPLE_COUNT) {
+    return;
+  }
+  uint16_t reading = channel.accumulator >> OVERSAMPLE_SHIFT;
+  channel.accumulator = 0;
+  channel.count = 0;
+
+  if (!channel.primed) {
+    channel.filtered = reading << IIR_FRAC_BITS;
+    channel.primed = true;
+  } else {
+    // filtered += (reading - filtered) / 2^IIR_SHIFT, arranged to stay unsigned
+    channel.filtered = channel.filtered - (channel.filtered >> IIR_SHIFT)
+                     + (reading << (IIR_FRAC_BITS - IIR_SHIFT));
+  }
+  if (reading < channel.min) {
+    channel.min = reading;
+  }
+  if (reading > channel.max) {
+    channel.max = reading;
+  }
+}
+
+#ifdef ARDUINO
+
+uint8_t current = 0; // channel being converted
+
+void start_conversion() {
+  uint8_t pin = channels[current].pin;
+  ADMUX = (1 << REFS0) | (pin & 0x07); // AVcc reference like analogRead, low bits of the channel
+  ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+  ADCSRA |= (1 << ADSC);
+}
+
+// Single conversions started back to back rather than free running, so the multiplexer can be
+// switched between them without a conversion landing on the wrong channel. At a 125 kHz ADC
+// clock that's a conversion every 104us, or each battery at about 300 Hz after oversampling.
+void handle_adc_interrupt() {
+  add_sample(channels[current], ADC);
+  current = current + 1 == NUM_CHANNELS ? 0 : current + 1;
+  start_conversion();
+}
+
+void start_adc() {
+  ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0); // clk / 128
+  start_conversion();
+}
+
+BattReading read_channel(Channel index, bool reset) {
+  volatile AdcChannel &channel = channels[index];
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t filtered = channel.filtered;
+  uint16_t min = channel.min;
+  uint16_t max = channel.max;
+  if (reset) {
+    channel.min = 0xFFFF;
+    channel.max = 0;
+  }
+  SREG = sreg;
+
+  uint16_t reading = (filtered + (1 << (IIR_FRAC_BITS - 1))) >> IIR_FRAC_BITS;
+  if (min > max) { // no complete reading since the last read
+    min = max = reading;
+  }
+  return BattReading{
+      .mv = BattMv::apply(reading),
+      .min_mv = BattMv::apply(min),
+      .max_mv = BattMv::apply(max),
+  };
+}
+
+#else
+
+// No interrupts on the host, just sample a block on demand
+void start_adc() {}
+
+BattReading read_channel(Channel index, bool reset __unused) {
+  volatile AdcChannel &channel = channels[index];
+  for (uint8_t i = 0; i < OVERSAMPLE_COUNT; i++) {
+    add_sample(channel, analogRead(channel.pin));
+  }
+  uint16_t reading = (channel.filtered + (1 << (IIR_FRAC_BITS - 1))) >> IIR_FRAC_BITS;
+  channel.min = 0xFFFF;
+  channel.max = 0;
+  return BattReading{
+      .mv = BattMv::apply(reading),
+      .min_mv = BattMv::apply(reading),
+      .max_mv = BattMv::apply(reading),
+  };
+}
+
+#endif
+
+} // namespace
+
 void setup() {
   pinMode(pinout::MAIN_BATT_VOLTAGE, INPUT);
   pinMode(pinout::ACTUATOR_BATT_VOLTAGE, INPUT);
   pinMode(pinout::KEY_SWITCH_IN, INPUT_PULLUP);
+  start_adc();
 }
 
 bool is_armed() {
-  return digitalRead(pinout::KEY_SWITCH_IN);
+  return fast_pin::FastPin<pinout::KEY_SWITCH_IN>::read();
 }
 
 bool contact;
@@ -23,13 +155,24 @@ void set_contact(bool value) {
   contact = value;
 }
 
-// The math at the end of these scales the arduino's 0-1023 analog value to a voltage based on
-// the resistor divider, without overflowing a uint16_t
 uint16_t get_main_batt_mv() {
-  return static_cast<uint16_t>(analogRead(pinout::MAIN_BATT_VOLTAGE)) * 48 / 17 * 5;
+  return read_channel(MAIN_BATT, false).mv;
 }
 uint16_t get_actuator_batt_mv() {
-  return static_cast<uint16_t>(analogRead(pinout::ACTUATOR_BATT_VOLTAGE)) * 48 / 17 * 5;
+  return read_channel(ACTUATOR_BATT, false).mv;
+}
+
+BattReading read_main_batt() {
+  return read_channel(MAIN_BATT, true);
+}
+BattReading read_actuator_batt() {
+  return read_channel(ACTUATOR_BATT, true);
 }
 
 } // namespace sensors
+
+#ifdef ARDUINO
+ISR(ADC_vect) {
+  sensors::handle_adc_interrupt();
+}
+#endif
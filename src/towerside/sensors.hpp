@@ -5,11 +5,25 @@
 
 namespace sensors {
 
+// Filtered reading of a battery, and its lowest and highest point since the last time it was
+// read, so sag under load (ignition) shows up even between 10 Hz reports
+struct BattReading {
+  uint16_t mv;
+  uint16_t min_mv;
+  uint16_t max_mv;
+};
+
+// Starts converting the battery channels in the background. Nothing else on towerside may use
+// analogRead after this, the ADC belongs to the interrupt.
 void setup();
 
 uint16_t get_main_batt_mv();
 uint16_t get_actuator_batt_mv();
 
+// Same as the getters above, and starts a new min/max window
+BattReading read_main_batt();
+BattReading read_actuator_batt();
+
 bool is_armed();
 bool has_contact();
 void set_contact(bool value);
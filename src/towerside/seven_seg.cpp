@@ -39,6 +39,130 @@ const uint8_t pinoutMap[] = {
 };
 
 uint8_t digit_values[2] = {0, 0};
+
+#ifdef ARDUINO
+
+namespace {
+
+// Where the display pins sit on the Mega2560's ports. The interrupt writes whole ports
+// instead of going through digitalWrite, so these have to follow pinout.hpp.
+static_assert(pinout::SEVENSEG_D1 == 43 && pinout::SEVENSEG_D2 == 39 &&
+              pinout::SEVENSEG_A == 38 && pinout::SEVENSEG_B == 42 &&
+              pinout::SEVENSEG_C == 37 && pinout::SEVENSEG_D == 45 &&
+              pinout::SEVENSEG_E == 41 && pinout::SEVENSEG_F == 46 &&
+              pinout::SEVENSEG_G == 40 && pinout::SEVENSEG_DP == 44,
+              "seven segment pins moved, update the port bits in seven_seg.cpp");
+
+enum Port : uint8_t { PORT_L, PORT_G, PORT_D, PORT_C };
+
+struct PortBit {
+  Port port;
+  uint8_t mask;
+};
+
+// Segments A to G, same order as digitMap
+const PortBit segmentBits[] = {
+  {PORT_D, 1 << 7}, // A, 38 = PD7
+  {PORT_L, 1 << 7}, // B, 42 = PL7
+  {PORT_C, 1 << 0}, // C, 37 = PC0
+  {PORT_L, 1 << 4}, // D, 45 = PL4
+  {PORT_G, 1 << 0}, // E, 41 = PG0
+  {PORT_L, 1 << 3}, // F, 46 = PL3
+  {PORT_G, 1 << 1}  // G, 40 = PG1
+};
+
+const uint8_t L_DP = 1 << 5; // 44 = PL5
+const uint8_t L_D1 = 1 << 6; // 43 = PL6
+const uint8_t G_D2 = 1 << 2; // 39 = PG2
+
+// Every display bit on each port, the rest of the port is left alone
+const uint8_t L_MASK = (1 << 7) | (1 << 4) | (1 << 3) | L_DP | L_D1;
+const uint8_t G_MASK = (1 << 0) | (1 << 1) | G_D2;
+const uint8_t D_MASK = 1 << 7;
+const uint8_t C_MASK = 1 << 0;
+
+// Port values for one digit with both digit selects still off
+struct Frame {
+  uint8_t l;
+  uint8_t g;
+  uint8_t d;
+  uint8_t c;
+};
+
+// Shared with the timer interrupt, only written with interrupts masked
+volatile Frame frames[2];
+volatile uint8_t current_digit = 0;
+
+Frame build_frame(uint8_t value) {
+  // segments and the decimal point are active low, start with everything off
+  Frame frame = {static_cast<uint8_t>(L_MASK & ~L_D1), static_cast<uint8_t>(G_MASK & ~G_D2), D_MASK, C_MASK};
+  for (uint8_t i = 0; i < 7; i++) {
+    if (digitMap[value] & (1 << i)) {
+      uint8_t *port = segmentBits[i].port == PORT_L ? &frame.l
+                    : segmentBits[i].port == PORT_G ? &frame.g
+                    : segmentBits[i].port == PORT_D ? &frame.d
+                    : &frame.c;
+      *port &= ~segmentBits[i].mask;
+    }
+  }
+  return frame;
+}
+
+void set_frame(uint8_t digit, uint8_t value) {
+  Frame frame = build_frame(value);
+  uint8_t sreg = SREG;
+  cli();
+  frames[digit].l = frame.l;
+  frames[digit].g = frame.g;
+  frames[digit].d = frame.d;
+  frames[digit].c = frame.c;
+  SREG = sreg;
+}
+
+} // namespace
+
+void handle_timer_interrupt() {
+  uint8_t digit = current_digit ^ 1;
+  current_digit = digit;
+  const volatile Frame &frame = frames[digit];
+  // Deselect both digits before touching any segment, and only select the new one once all of
+  // its segments are out, so nothing bleeds across.
+  PORTL &= ~L_D1;
+  PORTG &= ~G_D2;
+  PORTL = (PORTL & ~L_MASK) | frame.l;
+  PORTG = (PORTG & ~G_MASK) | frame.g;
+  PORTD = (PORTD & ~D_MASK) | frame.d;
+  PORTC = (PORTC & ~C_MASK) | frame.c;
+  if (digit == 0) {
+    PORTL |= L_D1;
+  } else {
+    PORTG |= G_D2;
+  }
+}
+
+void start_refresh() {
+  set_frame(0, digit_values[0]);
+  set_frame(1, digit_values[1]);
+
+  // Timer4 in CTC mode at 1 kHz: 16 MHz / 64 / 250, so each digit refreshes at 500 Hz
+  TCCR4A = 0;
+  TCCR4B = (1 << WGM42) | (1 << CS41) | (1 << CS40);
+  OCR4A = 249;
+  TIMSK4 = (1 << OCIE4A);
+}
+
+void set_value(uint8_t digit, uint8_t value) {
+  if (value != digit_values[digit]) {
+    digit_values[digit] = value;
+    set_frame(digit, value);
+  }
+}
+
+// Refreshed from the Timer4 interrupt
+void tick() {}
+
+#else
+
 uint8_t current_digit = 0;
 
 void set_digit(uint8_t digit, uint8_t value) {
@@ -52,6 +176,20 @@ void set_digit(uint8_t digit, uint8_t value) {
   digitalWrite(pinout::SEVENSEG_D2, digit == 1);
 }
 
+void start_refresh() {}
+
+void set_value(uint8_t digit, uint8_t value) {
+  digit_values[digit] = value;
+}
+
+// No timer interrupt on the host, multiplex from the main loop
+void tick() {
+  current_digit = 1 - current_digit;
+  set_digit(current_digit, digit_values[current_digit]);
+}
+
+#endif
+
 void setup() {
   pinMode(pinout::SEVENSEG_D1, OUTPUT);
   pinMode(pinout::SEVENSEG_D2, OUTPUT);
@@ -59,22 +197,24 @@ void setup() {
     pinMode(pinoutMap[i], OUTPUT);
   }
   pinMode(pinout::SEVENSEG_DP, OUTPUT);
+  start_refresh();
 }
 
 void display(const ActuatorMessage &state) {
-  digit_values[0] = static_cast<uint8_t>(state.ov101) << 0 |
-                    static_cast<uint8_t>(state.ov102) << 1 |
-                    static_cast<uint8_t>(state.ov103) << 2 |
-                    static_cast<uint8_t>(state.injector_valve) << 3;
-  digit_values[1] = static_cast<uint8_t>(state.tank_heating_1) << 0 |
-                    static_cast<uint8_t>(state.tank_heating_2) << 1 |
-                    static_cast<uint8_t>(state.ignition_primary) << 2 |
-                    static_cast<uint8_t>(state.ignition_secondary) << 3;
-}
-
-void tick() {
-  current_digit = 1 - current_digit;
-  set_digit(current_digit, digit_values[current_digit]);
+  set_value(0, static_cast<uint8_t>(state.ov101) << 0 |
+               static_cast<uint8_t>(state.ov102) << 1 |
+               static_cast<uint8_t>(state.ov103) << 2 |
+               static_cast<uint8_t>(state.injector_valve) << 3);
+  set_value(1, static_cast<uint8_t>(state.tank_heating_1) << 0 |
+               static_cast<uint8_t>(state.tank_heating_2) << 1 |
+               static_cast<uint8_t>(state.ignition_primary) << 2 |
+               static_cast<uint8_t>(state.ignition_secondary) << 3);
 }
 
 } // namespace seven_seg
+
+#ifdef ARDUINO
+ISR(TIMER4_COMPA_vect) {
+  seven_seg::handle_timer_interrupt();
+}
+#endif
@@ -3,10 +3,14 @@
 
 #include "common/config.hpp"
 
+// Two digit status display. On the board the digits are multiplexed from a 1 kHz Timer4
+// interrupt, so brightness doesn't depend on how long the main loop takes.
 namespace seven_seg {
 
 void setup();
 void display(const ActuatorMessage &state);
+
+// Multiplexes the digits on the host, a no-op on the board
 void tick();
 
 } // namespace seven_seg
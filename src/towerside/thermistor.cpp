@@ -0,0 +1,58 @@
+#include "thermistor.hpp"
+
+#include "common/mock_arduino.hpp"
+
+namespace thermistor {
+
+namespace {
+
+// Table entries are STEP counts apart, which makes finding the segment a shift and the
+// interpolation weight a mask
+constexpr uint8_t STEP_BITS = 6;
+constexpr uint16_t STEP = 1 << STEP_BITS;
+constexpr uint16_t NUM_ENTRIES = (ADC_MAX >> STEP_BITS) + 2; // one past the last reading
+
+struct Table {
+  uint16_t deci_kelvin[NUM_ENTRIES];
+};
+
+// C++11 has no std::index_sequence, and there's no STL on the AVR anyway
+template <uint16_t... I> struct Indices {};
+template <uint16_t N, uint16_t... I> struct MakeIndices: MakeIndices<N - 1, N - 1, I...> {};
+template <uint16_t... I> struct MakeIndices<0, I...> {
+  typedef Indices<I...> type;
+};
+
+template <uint16_t... I> constexpr Table make_table(Indices<I...>) {
+  return Table{{deci_kelvin_at_raw(static_cast<double>(I) * STEP)...}};
+}
+
+// In flash, since a table read with a runtime index would otherwise be copied into RAM
+constexpr Table TABLE PROGMEM = make_table(MakeIndices<NUM_ENTRIES>::type());
+
+// The divider is at its midpoint at T0
+static_assert(TABLE.deci_kelvin[2496 / STEP] >= 2975 && TABLE.deci_kelvin[2496 / STEP] <= 2990,
+              "thermistor table doesn't pass through T0");
+static_assert(raw_at_deci_kelvin(2982) >= 2490 && raw_at_deci_kelvin(2982) <= 2510,
+              "thermistor inverse doesn't pass through T0");
+static_assert(MAX_DECI_KELVIN <= 0x7FFF, "table entries and their differences have to fit in int16_t");
+
+} // namespace
+
+uint16_t to_deci_kelvin(uint16_t raw) {
+  if (raw == ERR_VAL) {
+    return ERR_VAL;
+  }
+  if (raw > ADC_MAX) {
+    raw = ADC_MAX;
+  }
+  uint8_t index = raw >> STEP_BITS;
+  uint8_t frac = raw & (STEP - 1);
+  int16_t low = pgm_read_word(&TABLE.deci_kelvin[index]);
+  int16_t high = pgm_read_word(&TABLE.deci_kelvin[index + 1]);
+  // NTC, so the table falls with the reading. Entries are at most MAX_DECI_KELVIN, so they and
+  // their differences fit in int16_t, and the product with a 6 bit weight in int32_t
+  return low + static_cast<int16_t>((static_cast<int32_t>(high - low) * frac) >> STEP_BITS);
+}
+
+} // namespace thermistor
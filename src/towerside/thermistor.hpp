@@ -0,0 +1,99 @@
+#ifndef THERMISTOR_H
+#define THERMISTOR_H
+
+#include <stdint.h>
+
+// Beta model of the tank heater thermistors. The heater boards report the thermistor as a
+// 12 bit reading of an NTC on the low side of a divider, against a 4.096V reference, so one
+// count is one mV.
+//
+// The part values below are placeholders (a common 10k B3950 NTC against a 10k resistor from
+// 5V), not read off the heater board schematic, which isn't in this repo. Confirm them there
+// before trusting any temperature, since telemetry, the LCD and the thermostat setpoint all go
+// through them.
+//
+// Everything here is constexpr so the lookup table and setpoints are worked out by the
+// compiler. Doubles only ever exist at compile time, the AVR just indexes and interpolates.
+// Written for C++11 constexpr (single return statements) since that's what the AVR core uses.
+namespace thermistor {
+
+constexpr double BETA = 3950; // K, placeholder
+constexpr double R0_OHMS = 10000; // at T0, placeholder
+constexpr double T0_K = 298.15;
+constexpr double FIXED_OHMS = 10000; // high side of the divider, placeholder
+constexpr double SUPPLY_MV = 5000; // divider supply, placeholder
+
+constexpr uint16_t ADC_MAX = 4095;
+constexpr uint16_t ERR_VAL = 0xFFFF; // same as SENSOR_ERR_VAL
+// Readings hotter than this (the bottom ~170 counts, where the divider is nearly shorted)
+// saturate here rather than running off towards infinity
+constexpr uint16_t MAX_DECI_KELVIN = 4000;
+
+namespace detail {
+
+constexpr double LN2 = 0.69314718055994530942;
+
+constexpr double square(double x) {
+  return x * x;
+}
+
+// 2 * atanh(y) = ln((1 + y) / (1 - y)), summed until the terms stop mattering
+constexpr double atanh_series(double y2, double term, int n) {
+  return n > 30 ? 0 : term / (2 * n + 1) + atanh_series(y2, term * y2, n + 1);
+}
+
+// Range reduction to [0.5, 2] by powers of two keeps the series short
+constexpr double ln(double x) {
+  return x > 2 ? ln(x / 2) + LN2
+       : x < 0.5 ? ln(x * 2) - LN2
+       : 2 * atanh_series(square((x - 1) / (x + 1)), (x - 1) / (x + 1), 0);
+}
+
+constexpr double exp_series(double x, double term, int n) {
+  return n > 20 ? 0 : term + exp_series(x, term * x / (n + 1), n + 1);
+}
+
+constexpr double exp(double x) {
+  return x > 0.5 || x < -0.5 ? square(exp(x / 2)) : exp_series(x, 1, 0);
+}
+
+constexpr double clamp(double x, double lo, double hi) {
+  return x < lo ? lo : x > hi ? hi : x;
+}
+
+} // namespace detail
+
+// Temperature for a thermistor resistance
+constexpr double kelvin_at_ohms(double ohms) {
+  return 1 / (1 / T0_K + detail::ln(ohms / R0_OHMS) / BETA);
+}
+
+// Thermistor resistance for a reading, clamped just inside the rails so the ends of the table
+// stay finite
+constexpr double ohms_at_mv(double mv) {
+  return FIXED_OHMS * mv / (SUPPLY_MV - mv);
+}
+constexpr double ohms_at_raw(double raw) {
+  return ohms_at_mv(detail::clamp(raw, 0.5, SUPPLY_MV - 0.5));
+}
+
+constexpr uint16_t deci_kelvin_at_raw(double raw) {
+  return static_cast<uint16_t>(detail::clamp(kelvin_at_ohms(ohms_at_raw(raw)) * 10 + 0.5, 0, MAX_DECI_KELVIN));
+}
+
+// Inverse, for turning a temperature into a raw setpoint at compile time
+constexpr double ohms_at_kelvin(double kelvin) {
+  return R0_OHMS * detail::exp(BETA * (1 / kelvin - 1 / T0_K));
+}
+constexpr uint16_t raw_at_deci_kelvin(uint16_t deci_kelvin) {
+  return static_cast<uint16_t>(detail::clamp(
+      SUPPLY_MV * ohms_at_kelvin(deci_kelvin / 10.0) / (ohms_at_kelvin(deci_kelvin / 10.0) + FIXED_OHMS) + 0.5,
+      0, ADC_MAX));
+}
+
+// Converts a raw 12 bit reading through the lookup table, ERR_VAL passes through
+uint16_t to_deci_kelvin(uint16_t raw);
+
+} // namespace thermistor
+
+#endif
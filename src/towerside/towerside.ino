@@ -1,18 +1,23 @@
 #include "common/config.cpp" // cursed subfolder compile
 #include "common/communication.hpp"
+#include "common/fast_pin.hpp"
 #include "config.hpp"
+#include "failsafe.hpp"
+#include "logger.hpp"
 #include "pinout.hpp"
 #include "seven_seg.hpp"
 #include "sensors.hpp"
 
 void setup() {
   Serial.begin(115200);
-  Serial2.begin(9600);
+  Serial2.begin(config::RADIO_BAUD);
   Wire.begin();
   Wire.setClock(10000);
   Wire.setWireTimeout(1000, true); // 1000 uS = 1mS timeout, true = reset the bus in this case
   seven_seg::setup();
   sensors::setup();
+  failsafe::setup();
+  logger::setup();
 
   pinMode(pinout::COMM_STATUS_LED,OUTPUT);
   pinMode(pinout::ARM_STATUS_LED,OUTPUT);
@@ -30,6 +35,7 @@ void setup() {
     communicator.read_byte();
     ActuatorMessage new_cmd;
     if (communicator.get_message(&new_cmd)) { // If we have a new message from clientside
+      failsafe::frame_received();
       // If we got the same message last time around (aka no RF interference) and we are armed, apply the command
       if (new_cmd == last_cmd && sensors::is_armed()) {
         current_cmd = new_cmd;
@@ -37,24 +43,32 @@ void setup() {
       last_cmd = new_cmd;
     }
 
-    // If we have got a message from clientside recently
-    bool has_contact = communicator.seconds_since_last_contact() < config::COMMUNICATION_TIMEOUT_S;
+    // If we have got a message from clientside recently. The failsafe timer keeps track of
+    // this in the background, see failsafe.hpp.
+    bool has_contact = !failsafe::tripped();
     sensors::set_contact(has_contact);
-    digitalWrite(pinout::COMM_STATUS_LED,sensors::has_contact());
-    digitalWrite(pinout::ARM_STATUS_LED,sensors::is_armed());
+    fast_pin::FastPin<pinout::COMM_STATUS_LED>::write(sensors::has_contact());
+    fast_pin::FastPin<pinout::ARM_STATUS_LED>::write(sensors::is_armed());
     if (!has_contact) {
       // Override clientside's command and go to safe state
       current_cmd = build_safe_state(current_cmd);
     }
 
     config::apply(current_cmd);
+    if (!has_contact) {
+      failsafe::safe_state_applied();
+    }
     seven_seg::display(current_cmd);
     seven_seg::tick();
+    logger::tick(current_cmd);
 
     // Periodically send back our status
     if (millis() > last_sensor_msg_time + config::SENSOR_MSG_INTERVAL_MS) {
       last_sensor_msg_time = millis();
-      communicator.send(config::build_sensor_message());
+      SensorMessage sensor_msg = config::build_sensor_message();
+      communicator.send(sensor_msg);
+      logger::log_sensors(sensor_msg);
+      config::stream_waveforms();
     }
   }
 }
@@ -0,0 +1,61 @@
+#include "waveform.hpp"
+
+namespace waveform {
+
+// The chunk that was asked for should come back within a read or two
+constexpr uint8_t MAX_STALE_READS = 3;
+
+bool Reader::tick(actuator::I2C &board) {
+  if (!reading) {
+    if (!board.get_waveform_status(&status) || !status.done) {
+      return true;
+    }
+    reading = true;
+    next = 0;
+    stale_reads = 0;
+    return false;
+  }
+
+  uint8_t index = board.read_waveform_chunk(next, samples + next);
+  if (index != next) {
+    // 0xFF means the capture went away, give up on it and pick it up again from the status
+    if (index == 0xFF || ++stale_reads > MAX_STALE_READS) {
+      reading = false;
+      return true;
+    }
+    return false;
+  }
+  stale_reads = 0;
+  next += actuator::I2C::WAVE_CHUNK_SIZE;
+  if (next < status.length && next < actuator::I2C::WAVE_NUM_SAMPLES) {
+    return false;
+  }
+
+  print(board);
+  board.arm_waveform(status.channel);
+  reading = false;
+  return true;
+}
+
+void Reader::print(const actuator::I2C &board) {
+  uint8_t length = status.length;
+  if (length > actuator::I2C::WAVE_NUM_SAMPLES) {
+    length = actuator::I2C::WAVE_NUM_SAMPLES;
+  }
+  uint8_t post_trigger = actuator::I2C::WAVE_NUM_SAMPLES - actuator::I2C::WAVE_PRETRIGGER_SAMPLES;
+  Serial.print("waveform,");
+  Serial.print(static_cast<unsigned int>(board.get_address()));
+  Serial.print(',');
+  Serial.print(static_cast<unsigned int>(status.channel));
+  Serial.print(',');
+  Serial.print(static_cast<unsigned long>(actuator::I2C::WAVE_SAMPLE_PERIOD_US) * status.decimation);
+  Serial.print(',');
+  Serial.print(static_cast<int>(length) - post_trigger);
+  for (uint8_t i = 0; i < length; i++) {
+    Serial.print(',');
+    Serial.print(actuator::I2C::WaveSampleMa::apply(samples[i]));
+  }
+  Serial.print('\n');
+}
+
+} // namespace waveform
@@ -0,0 +1,30 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stdint.h>
+
+#include "actuators.hpp"
+
+namespace waveform {
+
+// Pulls finished current captures off relay boards and prints them on the USB serial port,
+// one line per capture:
+// waveform,<address>,<channel>,<sample period us>,<trigger sample>,<mA>,<mA>,...
+// It does one I2C transaction per tick so the control loop never waits on a whole capture.
+class Reader {
+  uint8_t samples[actuator::I2C::WAVE_NUM_SAMPLES];
+  actuator::WaveformStatus status;
+  uint8_t next = 0; // next sample to read
+  bool reading = false;
+  uint8_t stale_reads = 0;
+
+  void print(const actuator::I2C &board);
+
+public:
+  // Returns true when it is finished with the board for now and can move on to another one
+  bool tick(actuator::I2C &board);
+};
+
+} // namespace waveform
+
+#endif